@@ -57,6 +57,7 @@ export async function getTableRows(params: {
   limit?: number;
   index_position?: number;
   key_type?: string;
+  reverse?: boolean;
 }) {
   return await chainClient.v1.chain.get_table_rows({
     json: true,
@@ -68,6 +69,7 @@ export async function getTableRows(params: {
     limit: params.limit || 100,
     index_position: params.index_position,
     key_type: params.key_type,
+    reverse: params.reverse,
   });
 }
 
@@ -105,12 +107,13 @@ export async function pushTransaction(serializedTransaction: any) {
 /**
  * Build, sign, and push a transaction using the service key.
  * Used for uploadchunk and completefile actions that the server handles.
+ * `return_value` carries the action's decoded return value (e.g. allocated IDs).
  */
 export async function buildAndSignTransaction(
   actionName: string,
   data: Record<string, unknown>,
   authorization?: PermissionLevel
-): Promise<{ transaction_id: string }> {
+): Promise<{ transaction_id: string; return_value?: unknown }> {
   await ensureChainActive();
   const info = await chainClient.v1.chain.get_info();
   const contractAccount = CHAIN_CONFIG.contractAccount;
@@ -160,7 +163,72 @@ export async function buildAndSignTransaction(
     PackedTransaction.fromSigned(signedTx)
   );
 
-  return { transaction_id: String(result.transaction_id) };
+  return {
+    transaction_id: String(result.transaction_id),
+    return_value: (result as any).processed?.action_traces?.[0]?.return_value_data,
+  };
+}
+
+/**
+ * Run a read-only contract action and return its decoded return value.
+ * Read-only transactions are unsigned, never enter a block and run in
+ * parallel on the node, so they suit lookups that need contract logic.
+ */
+export async function callReadOnlyAction(
+  actionName: string,
+  data: Record<string, unknown>
+): Promise<any> {
+  const info = await chainClient.v1.chain.get_info();
+  const contractAccount = CHAIN_CONFIG.contractAccount;
+
+  const { abi } = await chainClient.v1.chain.get_abi(contractAccount);
+  if (!abi) {
+    throw new Error('Failed to fetch contract ABI');
+  }
+
+  const action = Action.from({
+    account: contractAccount,
+    name: Name.from(actionName),
+    authorization: [],
+    data,
+  }, abi);
+
+  const transaction = Transaction.from({
+    expiration: TimePointSec.fromMilliseconds(info.head_block_time.toMilliseconds() + 60000),
+    ref_block_num: info.head_block_num.value & 0xffff,
+    ref_block_prefix: info.head_block_id.array.slice(8, 12).reduce(
+      (val: number, byte: number, i: number) => val | (byte << (i * 8)),
+      0
+    ) >>> 0,
+    actions: [action],
+  });
+
+  const signedTx = SignedTransaction.from({ ...transaction, signatures: [] });
+  const result = await chainClient.v1.chain.send_read_only_transaction(
+    PackedTransaction.fromSigned(signedTx)
+  );
+  const trace = (result as any).processed?.action_traces?.[0];
+  if (!trace) {
+    throw new Error(`${actionName} returned no trace: ${JSON.stringify((result as any).processed?.except ?? result)}`);
+  }
+  return trace.return_value_data;
+}
+
+/**
+ * Fetch a completed file's download plan (getmanifest), following its
+ * 256-chunk pages so the result lists every chunk in index order.
+ * `reader` selects which wrapped DEK comes back; pass '' for layout only.
+ */
+export async function getFileManifest(fileId: string, reader = ''): Promise<any> {
+  const manifest = await callReadOnlyAction('getmanifest', { file_id: fileId, reader, start_index: 0 });
+  while (manifest.next_chunk_index < manifest.total_chunks) {
+    const page = await callReadOnlyAction('getmanifest', {
+      file_id: fileId, reader, start_index: manifest.next_chunk_index,
+    });
+    manifest.chunks.push(...page.chunks);
+    manifest.next_chunk_index = page.next_chunk_index;
+  }
+  return manifest;
 }
 
 /**
@@ -58,6 +58,30 @@ export async function calculateFileHash(filePath: string): Promise<string> {
   return hash.digest('hex');
 }
 
+// Hash one chunk the way the contract does (leaf of the chunk Merkle tree)
+export function hashChunk(chunk: Buffer): Buffer {
+  return crypto.createHash('sha256').update(chunk).digest();
+}
+
+// Root of the Merkle mountain range the contract accumulates over chunk
+// hashes (in chunk_index order): perfect subtrees with sha256(left || right)
+// interior nodes, peaks bagged right to left. completefile checks this root.
+export function chunkMerkleRoot(leaves: Buffer[]): Buffer {
+  const peaks: Buffer[] = [];
+  leaves.forEach((leaf, i) => {
+    let node = leaf;
+    for (let count = i; count & 1; count >>= 1) {
+      node = crypto.createHash('sha256').update(peaks.pop()!).update(node).digest();
+    }
+    peaks.push(node);
+  });
+  let root = peaks[peaks.length - 1];
+  for (let i = peaks.length - 2; i >= 0; i--) {
+    root = crypto.createHash('sha256').update(peaks[i]).update(root).digest();
+  }
+  return root;
+}
+
 // Calculate total number of chunks for a file
 export function calculateTotalChunks(fileSize: number): number {
   return Math.ceil(fileSize / CHUNK_SIZE);
@@ -96,3 +120,27 @@ export async function fileExists(filePath: string): Promise<boolean> {
 export function getChunkSize(): number {
   return CHUNK_SIZE;
 }
+
+// Decode an uploadchunk payload as it appears in action history. Actions
+// pushed before the raw-bytes ABI carry base64 text; newer ones carry the
+// hex encoding of the `bytes` field.
+export function decodeChunkPayload(data: string): Buffer {
+  if (data.length % 2 === 0 && /^[0-9a-f]*$/i.test(data)) {
+    return Buffer.from(data, 'hex');
+  }
+  return Buffer.from(data, 'base64');
+}
+
+// Decode a legacy artchunks table row. Rows with format_version 1 hold raw
+// bytes (hex in JSON) in chunk_bytes; older rows hold base64 text in
+// chunk_data. The migchunks action moves both kinds into filechunks.
+export function decodeChunkRow(row: {
+  chunk_data?: string;
+  chunk_bytes?: string;
+  format_version?: number;
+}): Buffer {
+  if (row.format_version === 1 && row.chunk_bytes !== undefined) {
+    return Buffer.from(row.chunk_bytes, 'hex');
+  }
+  return Buffer.from(row.chunk_data || '', 'base64');
+}
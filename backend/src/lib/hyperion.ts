@@ -1,4 +1,7 @@
+import { decodeChunkPayload, hashChunk } from './fileUpload.js';
+
 const HYPERION_URL = process.env.HYPERION_URL || 'http://localhost:7000';
+const CHAIN_HISTORY_URL = process.env.CHAIN_HISTORY_URL || 'http://localhost:8888';
 
 export async function getActions(params: {
   account?: string;
@@ -46,9 +49,59 @@ export async function getFileChunks(fileId: number, owner: string) {
   return chunks;
 }
 
-// Get the latest extras for an artwork from chain history.
-// Queries setextras actions and returns the most recent extras_json (parsed).
+function parseExtras(extrasJson: string) {
+  try {
+    return JSON.parse(extrasJson);
+  } catch {
+    return extrasJson;
+  }
+}
+
+// Get the latest extras for an artwork from chain history. The artwork row
+// names the block of the latest setextras and the sha256 of its extras_json,
+// so that one block is read and checked. Artworks with no pointer yet (extras
+// set before the contract recorded one) fall back to scanning recent actions.
 export async function getArtworkExtras(artworkId: number) {
+  const res = await fetch(`${CHAIN_HISTORY_URL}/v1/chain/get_table_rows`, {
+    method: 'POST',
+    headers: { 'Content-Type': 'application/json' },
+    body: JSON.stringify({
+      code: 'verarta.core',
+      scope: 'verarta.core',
+      table: 'artworks',
+      json: true,
+      lower_bound: String(artworkId),
+      upper_bound: String(artworkId),
+      limit: 1,
+    }),
+  });
+  if (!res.ok) throw new Error(`get_table_rows artworks failed: ${res.statusText}`);
+  const artwork = ((await res.json()) as any).rows?.[0];
+
+  if (artwork?.extras_block) {
+    const blockRes = await fetch(`${CHAIN_HISTORY_URL}/v1/chain/get_block`, {
+      method: 'POST',
+      headers: { 'Content-Type': 'application/json' },
+      body: JSON.stringify({ block_num_or_id: artwork.extras_block }),
+    });
+    if (!blockRes.ok) throw new Error(`get_block ${artwork.extras_block} failed: ${blockRes.statusText}`);
+    const block: any = await blockRes.json();
+
+    // Several calls may share the block; the hash picks the current one
+    for (const receipt of block.transactions || []) {
+      const actions = typeof receipt.trx === 'object' ? receipt.trx.transaction?.actions : null;
+      for (const action of actions || []) {
+        if (action.account !== 'verarta.core' || action.name !== 'setextras') continue;
+        if (String(action.data?.artwork_id) !== String(artworkId)) continue;
+        const extrasJson: string = action.data.extras_json;
+        if (hashChunk(Buffer.from(extrasJson, 'utf8')).toString('hex') === artwork.extras_hash) {
+          return parseExtras(extrasJson);
+        }
+      }
+    }
+    throw new Error(`setextras for artwork ${artworkId} not found in block ${artwork.extras_block}`);
+  }
+
   const result = await getActions({
     filter: 'verarta.core:setextras',
     limit: 100,
@@ -61,22 +114,75 @@ export async function getArtworkExtras(artworkId: number) {
   );
 
   if (!match) return null;
-
-  try {
-    return JSON.parse(match.act.data.extras_json);
-  } catch {
-    return match.act.data.extras_json;
-  }
+  return parseExtras(match.act.data.extras_json);
 }
 
 // Reassemble file from chunks
 export async function downloadFile(fileId: number, owner: string) {
   const chunks = await getFileChunks(fileId, owner);
 
-  // Convert base64 chunks to binary and concatenate
+  // Convert chunk payloads (base64 or hex bytes) to binary and concatenate
   const buffers = chunks.map((chunk: any) =>
-    Buffer.from(chunk.chunk_data, 'base64')
+    decodeChunkPayload(chunk.chunk_data)
   );
 
   return Buffer.concat(buffers);
 }
+
+// Find the chunk data for (fileId, chunkIndex) among the verarta.core upload
+// actions of a get_block response. `bytes` fields come back as hex.
+function findChunkInBlock(block: any, fileId: string, chunkIndex: number): string | null {
+  for (const receipt of block.transactions || []) {
+    // Deferred transactions appear as a bare id and carry no action data
+    const actions = typeof receipt.trx === 'object' ? receipt.trx.transaction?.actions : null;
+    for (const action of actions || []) {
+      if (action.account !== 'verarta.core' || String(action.data?.file_id) !== fileId) continue;
+      if (action.name === 'uploadchunk' && action.data.chunk_index === chunkIndex) {
+        return action.data.chunk_data;
+      }
+      if (action.name === 'uploadchunks') {
+        const match = action.data.chunks.find((c: any) => c.chunk_index === chunkIndex);
+        if (match) return match.chunk_data;
+      }
+    }
+  }
+  return null;
+}
+
+// Rebuild the chunks of a trace-only file (storage_mode 1) from the blocks
+// named in its chunkreceipts rows. Each chunk is checked against the
+// receipt's sha256, so a bad copy can be re-fetched on its own.
+export async function getTraceChunks(
+  fileId: string,
+  receipts: Array<{ chunk_index: number; chunk_hash: string; block_num: number }>
+): Promise<Map<number, Buffer>> {
+  const blocks = new Map<number, any>();
+  const chunks = new Map<number, Buffer>();
+
+  for (const receipt of receipts) {
+    let block = blocks.get(receipt.block_num);
+    if (!block) {
+      const res = await fetch(`${CHAIN_HISTORY_URL}/v1/chain/get_block`, {
+        method: 'POST',
+        headers: { 'Content-Type': 'application/json' },
+        body: JSON.stringify({ block_num_or_id: receipt.block_num }),
+      });
+      if (!res.ok) throw new Error(`get_block ${receipt.block_num} failed: ${res.statusText}`);
+      block = await res.json();
+      blocks.set(receipt.block_num, block);
+    }
+
+    const data = findChunkInBlock(block, fileId, receipt.chunk_index);
+    if (data === null) {
+      throw new Error(`Chunk ${receipt.chunk_index} of file ${fileId} not found in block ${receipt.block_num}`);
+    }
+
+    const chunk = Buffer.from(data, 'hex');
+    if (hashChunk(chunk).toString('hex') !== receipt.chunk_hash) {
+      throw new Error(`Chunk ${receipt.chunk_index} of file ${fileId} failed its hash check`);
+    }
+    chunks.set(receipt.chunk_index, chunk);
+  }
+
+  return chunks;
+}
@@ -4,6 +4,8 @@ import { createHash } from 'crypto';
 import sharp from 'sharp';
 import { getTableRows } from './antelope.js';
 import { decryptDek, decryptFile } from './crypto.js';
+import { decodeChunkRow } from './fileUpload.js';
+import { getTraceChunks } from './hyperion.js';
 
 const UPLOADS_DIR = process.env.UPLOADS_DIR || join(process.cwd(), 'uploads');
 
@@ -12,7 +14,45 @@ const UPLOADS_DIR = process.env.UPLOADS_DIR || join(process.cwd(), 'uploads');
  * Returns the file metadata row if found.
  */
 async function findThumbnailFile(artworkId: string): Promise<any | null> {
-  // Query artfiles by artwork_id using secondary index (byartwork)
+  // Artworks carrying the thumbnail_file_id aggregate point straight at it
+  const artwork = await getTableRows({
+    code: 'verarta.core',
+    scope: 'verarta.core',
+    table: 'artworks',
+    lower_bound: artworkId,
+    upper_bound: artworkId,
+    limit: 1,
+  });
+  const thumbnailFileId = artwork.rows[0]?.thumbnail_file_id;
+  if (thumbnailFileId) {
+    const file = await getTableRows({
+      code: 'verarta.core',
+      scope: 'verarta.core',
+      table: 'artfiles',
+      lower_bound: String(thumbnailFileId),
+      upper_bound: String(thumbnailFileId),
+      limit: 1,
+    });
+    if (file.rows[0]?.upload_complete) return file.rows[0];
+  }
+
+  // Explicit thumbnails sit at (artwork_id, 1) in the bythumb index, so this
+  // is a bounded range read however many files the artwork has
+  const thumbKey = (BigInt(artworkId) << 64n) | 1n;
+  const thumbs = await getTableRows({
+    code: 'verarta.core',
+    scope: 'verarta.core',
+    table: 'artfiles',
+    key_type: 'i128',
+    lower_bound: thumbKey.toString(),
+    upper_bound: thumbKey.toString(),
+    limit: 10,
+    index_position: 4, // bythumb secondary index
+  });
+  const thumb = (thumbs.rows as any[]).find((row: any) => row.upload_complete);
+  if (thumb) return thumb;
+
+  // No thumbnail: fall back to the first completed main file
   const result = await getTableRows({
     code: 'verarta.core',
     scope: 'verarta.core',
@@ -27,59 +67,82 @@ async function findThumbnailFile(artworkId: string): Promise<any | null> {
   const files = (result.rows as any[]).filter(
     (row: any) => String(row.artwork_id) === artworkId && row.upload_complete
   );
-
-  // Prefer an explicit thumbnail file; fall back to the first main file
-  return files.find((f: any) => f.is_thumbnail) || files[0] || null;
+  return files[0] || null;
 }
 
 /**
  * Reassemble encrypted file from blockchain chunks.
  */
-async function reassembleFile(fileId: string, totalChunks: number): Promise<Buffer> {
+async function reassembleFile(fileId: string, totalChunks: number, storageMode?: number): Promise<Buffer> {
   // Each chunk is ~256KB; the chain API's 15ms-per-row ABI serialization
-  // deadline can timeout when fetching multiple large chunks at once.
-  // Strategy: find the first chunk's primary key via secondary index (limit=1),
-  // then paginate by primary key one chunk at a time.
+  // deadline can timeout when fetching multiple large chunks at once, so
+  // rows are fetched one at a time.
   const chainUrl = process.env.CHAIN_HISTORY_URL || 'http://localhost:8888';
 
   async function fetchRows(body: Record<string, unknown>) {
     const resp = await fetch(`${chainUrl}/v1/chain/get_table_rows`, {
       method: 'POST',
       headers: { 'Content-Type': 'application/json' },
-      body: JSON.stringify({ code: 'verarta.core', scope: 'verarta.core', table: 'artchunks', json: true, ...body }),
+      body: JSON.stringify({ code: 'verarta.core', json: true, ...body }),
     });
     return await resp.json() as any;
   }
 
-  // Step 1: Find the first chunk's primary key via secondary index
-  const first = await fetchRows({
-    index_position: 2, key_type: 'i64',
-    lower_bound: fileId, upper_bound: fileId, limit: 1,
-  });
-
-  if (!first.rows?.length) {
-    throw new Error(`No chunks found for file ${fileId}`);
+  // Trace-only files keep small receipts in RAM; the data comes from the
+  // blocks they name
+  if (storageMode === 1) {
+    const receipts = await fetchRows({
+      scope: fileId, table: 'chunkreceipts', lower_bound: '0', limit: totalChunks,
+    });
+    const chunkMap = await getTraceChunks(fileId, receipts.rows || []);
+    if (chunkMap.size === 0) {
+      throw new Error(`No chunks found for file ${fileId}`);
+    }
+    const sorted = [...chunkMap.entries()].sort((a, b) => a[0] - b[0]);
+    return Buffer.concat(sorted.map(([, buf]) => buf));
   }
 
-  // Step 2: Paginate by primary key (chunk_id), one at a time
+  // Chunks live in the file's filechunks scope keyed by chunk_index, so the
+  // index is the pagination key
   const chunkMap = new Map<number, Buffer>();
-  let lowerBound = String(first.rows[0].chunk_id);
+  for (let index = 0; index < totalChunks; index++) {
+    const result = await fetchRows({
+      scope: fileId, table: 'filechunks', lower_bound: String(index), limit: 1,
+    });
+    const row = result.rows?.[0];
+    if (!row) break;
+    chunkMap.set(row.chunk_index, Buffer.from(row.chunk_data, 'hex'));
+    index = row.chunk_index;
+  }
 
-  for (let i = 0; i < totalChunks + 5 && chunkMap.size < totalChunks; i++) {
-    const result = await fetchRows({ lower_bound: lowerBound, limit: 1 });
+  // Files not yet moved by migchunks: find the first legacy row via the
+  // byfile secondary index, then paginate by primary key (chunk_id)
+  if (chunkMap.size < totalChunks) {
+    const legacy = (body: Record<string, unknown>) =>
+      fetchRows({ scope: 'verarta.core', table: 'artchunks', ...body });
 
-    for (const row of result.rows || []) {
-      if (String(row.file_id) === fileId) {
-        chunkMap.set(row.chunk_index, Buffer.from(row.chunk_data, 'base64'));
+    const first = await legacy({
+      index_position: 2, key_type: 'i64',
+      lower_bound: fileId, upper_bound: fileId, limit: 1,
+    });
+
+    let lowerBound = first.rows?.length ? String(first.rows[0].chunk_id) : null;
+    for (let i = 0; lowerBound !== null && i < totalChunks + 5 && chunkMap.size < totalChunks; i++) {
+      const result = await legacy({ lower_bound: lowerBound, limit: 1 });
+
+      for (const row of result.rows || []) {
+        if (String(row.file_id) === fileId && !chunkMap.has(row.chunk_index)) {
+          chunkMap.set(row.chunk_index, decodeChunkRow(row));
+        }
       }
-    }
 
-    if (!result.more || !result.next_key) break;
-    lowerBound = String(result.next_key);
+      if (!result.more || !result.next_key) break;
+      lowerBound = String(result.next_key);
 
-    // If we've moved past our file's chunks, stop
-    const lastRow = result.rows?.[result.rows.length - 1];
-    if (lastRow && String(lastRow.file_id) !== fileId && chunkMap.size > 0) break;
+      // If we've moved past our file's chunks, stop
+      const lastRow = result.rows?.[result.rows.length - 1];
+      if (lastRow && String(lastRow.file_id) !== fileId) break;
+    }
   }
 
   if (chunkMap.size === 0) {
@@ -155,9 +218,10 @@ export async function generateCachedThumbnail(artworkId: string): Promise<string
       return null;
     }
 
-    // 3. Reassemble encrypted thumbnail from chunks
-    const fileId = String(thumbFile.file_id);
-    const encryptedBuffer = await reassembleFile(fileId, thumbFile.total_chunks);
+    // 3. Reassemble encrypted thumbnail from chunks (a duplicate file reads
+    // the chunks of the file it was deduplicated against)
+    const fileId = String(thumbFile.chunk_file_id || thumbFile.file_id);
+    const encryptedBuffer = await reassembleFile(fileId, thumbFile.total_chunks, thumbFile.storage_mode);
 
     // 4. Decrypt the file
     const plaintext = await decryptFile(
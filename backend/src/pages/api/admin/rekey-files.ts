@@ -2,6 +2,9 @@ import type { APIRoute } from 'astro';
 import { requireAdmin } from '../../../middleware/auth.js';
 import { buildAndSignTransaction } from '../../../lib/antelope.js';
 
+// Contract limit on files per addadmindeks action (MAX_ADMIN_DEK_BATCH)
+const MAX_ADMIN_DEK_BATCH = 100;
+
 interface RekeyEntry {
   file_id: number;
   new_encrypted_dek: string;
@@ -33,6 +36,7 @@ export const POST: APIRoute = async (context) => {
   let failed = 0;
   const errors: Array<{ file_id: number; error: string }> = [];
 
+  const valid: RekeyEntry[] = [];
   for (const entry of files) {
     const { file_id, new_encrypted_dek } = entry;
     if (!file_id || !new_encrypted_dek) {
@@ -40,16 +44,19 @@ export const POST: APIRoute = async (context) => {
       errors.push({ file_id: file_id ?? 0, error: 'Missing file_id or new_encrypted_dek' });
       continue;
     }
+    valid.push({ file_id, new_encrypted_dek });
+  }
 
+  // A batch is one transaction: it applies or fails as a whole
+  for (let i = 0; i < valid.length; i += MAX_ADMIN_DEK_BATCH) {
+    const deks = valid.slice(i, i + MAX_ADMIN_DEK_BATCH);
     try {
-      await buildAndSignTransaction('addadmindek', { file_id, new_encrypted_dek });
-      processed++;
+      await buildAndSignTransaction('addadmindeks', { deks });
+      processed += deks.length;
     } catch (err) {
-      failed++;
-      errors.push({
-        file_id,
-        error: err instanceof Error ? err.message : String(err),
-      });
+      failed += deks.length;
+      const error = err instanceof Error ? err.message : String(err);
+      errors.push(...deks.map(({ file_id }) => ({ file_id, error })));
     }
   }
 
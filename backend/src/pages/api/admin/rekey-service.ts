@@ -5,6 +5,9 @@ import { query } from '../../../lib/db.js';
 import { decryptDek } from '../../../lib/crypto.js';
 import sodium from 'libsodium-wrappers';
 
+// Contract limit on files per addadmindeks action (MAX_ADMIN_DEK_BATCH)
+const MAX_ADMIN_DEK_BATCH = 100;
+
 /**
  * Server-side re-key: decrypt each file's admin DEK using the requesting admin's
  * backed-up private key (from DB), then re-encrypt for the service X25519 key.
@@ -141,6 +144,7 @@ export const POST: APIRoute = async (context) => {
     let processed = 0;
     let failed = 0;
     const errors: Array<{ file_id: string; error: string }> = [];
+    const deks: Array<{ file_id: number; new_encrypted_dek: string }> = [];
 
     for (const file of filesToRekey) {
       const myEncDek = file.admin_encrypted_deks[myKeyIndex];
@@ -174,13 +178,10 @@ export const POST: APIRoute = async (context) => {
         const newEncDekB64 = sodium.to_base64(newEncDek, sodium.base64_variants.ORIGINAL);
         const ephPubB64 = sodium.to_base64(ephemeralKeyPair.publicKey, sodium.base64_variants.ORIGINAL);
 
-        // Push addadmindek transaction
-        await buildAndSignTransaction('addadmindek', {
+        deks.push({
           file_id: Number(file.file_id),
           new_encrypted_dek: `${newEncDekB64}.${ephPubB64}`,
         });
-
-        processed++;
       } catch (err) {
         failed++;
         errors.push({
@@ -190,6 +191,19 @@ export const POST: APIRoute = async (context) => {
       }
     }
 
+    // 6. Push the re-encrypted DEKs in addadmindeks batches
+    for (let i = 0; i < deks.length; i += MAX_ADMIN_DEK_BATCH) {
+      const batch = deks.slice(i, i + MAX_ADMIN_DEK_BATCH);
+      try {
+        await buildAndSignTransaction('addadmindeks', { deks: batch });
+        processed += batch.length;
+      } catch (err) {
+        failed += batch.length;
+        const error = err instanceof Error ? err.message : String(err);
+        errors.push(...batch.map(({ file_id }) => ({ file_id: String(file_id), error })));
+      }
+    }
+
     return new Response(JSON.stringify({
       success: true,
       processed,
@@ -6,6 +6,11 @@ import { PermissionLevel, Name } from '@wharfkit/antelope';
 
 const DELETED_ACCOUNT = 'deleted';
 
+// Files re-keyed per xferbatch action (contract MAX_TRANSFER_BATCH). Artworks
+// with more files than this go through the phased xferbegin/xferbatch/xferfinish
+// transfer instead of a single transferart.
+const MAX_TRANSFER_BATCH = 50;
+
 export const POST: APIRoute = async (context) => {
   try {
     const authResult = await requireAuth(context);
@@ -45,7 +50,9 @@ export const POST: APIRoute = async (context) => {
       });
     }
 
-    // Fetch all files for this artwork from on-chain artfiles table
+    // Fetch all files for this artwork from on-chain artfiles table, in
+    // byartwork order (the order the phased transfer walks them). Every row
+    // shares the same secondary key, so the result cannot be paged.
     const filesResult = await getTableRows({
       code: 'verarta.core',
       scope: 'verarta.core',
@@ -53,19 +60,22 @@ export const POST: APIRoute = async (context) => {
       index_position: 2,
       key_type: 'i64',
       lower_bound: id,
-      upper_bound: String(BigInt(id) + 1n),
-      limit: 100,
+      upper_bound: id,
+      limit: 1000,
     });
+    if (filesResult.more) {
+      throw new Error(`Artwork ${id} has too many files to list in one query`);
+    }
 
+    // Only files the caller owns and that are not mid-deletefile can be
+    // handed over: an earlier partial transferart may have left files with
+    // another owner, and xferbatch passes over both kinds.
     const artworkFiles = filesResult.rows.filter(
       (r: any) => String(r.artwork_id) === id
+        && String(r.owner) === user.blockchainAccount
+        && !r.deleting
     );
 
-    // Build dummy DEK arrays — files become undecryptable (correct for deleted artwork)
-    const file_ids = artworkFiles.map((f: any) => f.file_id);
-    const new_encrypted_deks = artworkFiles.map(() => '');
-    const new_auth_tags = artworkFiles.map(() => '');
-
     // Transfer artwork to 'deleted' account on-chain
     // Authorization: user@owner — verarta.core@active is on every user's owner
     // permission (not active), so we must declare owner here.
@@ -73,20 +83,40 @@ export const POST: APIRoute = async (context) => {
       actor: Name.from(user.blockchainAccount),
       permission: 'owner',
     });
+    const artwork_id = parseInt(id);
+    const from = user.blockchainAccount;
 
-    await buildAndSignTransaction(
-      'transferart',
-      {
-        artwork_id: parseInt(id),
-        from: user.blockchainAccount,
-        to: DELETED_ACCOUNT,
-        file_ids,
-        new_encrypted_deks,
-        new_auth_tags,
-        memo: '',
-      },
-      authorization
-    );
+    // Dummy DEKs — files become undecryptable (correct for deleted artwork)
+    if (artworkFiles.length <= MAX_TRANSFER_BATCH) {
+      await buildAndSignTransaction(
+        'transferart',
+        {
+          artwork_id,
+          from,
+          to: DELETED_ACCOUNT,
+          file_ids: artworkFiles.map((f: any) => f.file_id),
+          new_encrypted_deks: artworkFiles.map(() => ''),
+          new_auth_tags: artworkFiles.map(() => ''),
+          memo: '',
+        },
+        authorization
+      );
+    } else {
+      await buildAndSignTransaction(
+        'xferbegin',
+        { artwork_id, from, to: DELETED_ACCOUNT, memo: '' },
+        authorization
+      );
+      for (let i = 0; i < artworkFiles.length; i += MAX_TRANSFER_BATCH) {
+        const files = artworkFiles.slice(i, i + MAX_TRANSFER_BATCH).map((f: any) => ({
+          file_id: f.file_id,
+          new_encrypted_dek: '',
+          new_auth_tag: '',
+        }));
+        await buildAndSignTransaction('xferbatch', { artwork_id, from, files }, authorization);
+      }
+      await buildAndSignTransaction('xferfinish', { artwork_id, from }, authorization);
+    }
 
     // Clean up postgres artwork_extras row
     await query(
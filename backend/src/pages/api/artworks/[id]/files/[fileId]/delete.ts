@@ -65,12 +65,18 @@ export const POST: APIRoute = async (context) => {
       });
     }
 
-    // Call deletefile action (signed by service key via get_self() auth)
-    await buildAndSignTransaction('deletefile', {
-      file_id: parseInt(fileId),
-      artwork_id: parseInt(id),
-      owner: user.blockchainAccount,
-    });
+    // Call deletefile action (signed by service key via get_self() auth).
+    // Each call erases a bounded number of chunk rows and returns true once
+    // the file row itself is gone, so repeat until it reports completion.
+    for (let attempt = 0; ; attempt++) {
+      const result = await buildAndSignTransaction('deletefile', {
+        file_id: parseInt(fileId),
+        artwork_id: parseInt(id),
+        owner: user.blockchainAccount,
+      });
+      if (result.return_value === true) break;
+      if (attempt >= 100) throw new Error('File deletion did not finish after 100 calls');
+    }
 
     return new Response(JSON.stringify({ success: true }), {
       status: 200,
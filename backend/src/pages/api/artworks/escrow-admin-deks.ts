@@ -2,6 +2,9 @@ import type { APIRoute } from 'astro';
 import { requireAuth } from '../../../middleware/auth.js';
 import { getTableRows, buildAndSignTransaction } from '../../../lib/antelope.js';
 
+// Contract limit on files per addadmindeks action (MAX_ADMIN_DEK_BATCH)
+const MAX_ADMIN_DEK_BATCH = 100;
+
 interface EscrowEntry {
   file_id: number;
   new_encrypted_dek: string; // format: "encryptedDek.ephemeralPubKey"
@@ -33,6 +36,7 @@ export const POST: APIRoute = async (context) => {
 
   let processed = 0;
   let failed = 0;
+  const owned: EscrowEntry[] = [];
 
   for (const entry of files) {
     const { file_id, new_encrypted_dek } = entry;
@@ -62,13 +66,22 @@ export const POST: APIRoute = async (context) => {
         continue;
       }
 
-      await buildAndSignTransaction('addadmindek', { file_id, new_encrypted_dek });
-      processed++;
+      owned.push({ file_id, new_encrypted_dek });
     } catch {
       failed++;
     }
   }
 
+  for (let i = 0; i < owned.length; i += MAX_ADMIN_DEK_BATCH) {
+    const deks = owned.slice(i, i + MAX_ADMIN_DEK_BATCH);
+    try {
+      await buildAndSignTransaction('addadmindeks', { deks });
+      processed += deks.length;
+    } catch {
+      failed += deks.length;
+    }
+  }
+
   return new Response(JSON.stringify({ success: true, processed, failed }), {
     status: 200,
     headers: { 'Content-Type': 'application/json' },
@@ -1,13 +1,44 @@
 import type { APIRoute } from 'astro';
 import { z } from 'zod';
 import { requireAuth } from '../../../../../middleware/auth.js';
-import { getTableRows } from '../../../../../lib/antelope.js';
+import { callReadOnlyAction, getFileManifest } from '../../../../../lib/antelope.js';
+import { hashChunk } from '../../../../../lib/fileUpload.js';
+import { getTraceChunks } from '../../../../../lib/hyperion.js';
 
 const FileIdSchema = z.string().regex(/^\d+$/, 'Invalid file ID');
 
+// Data requested per readchunks call; the contract caps it at 1MB and the
+// node's max_action_return_value_size must allow it
+const READCHUNKS_MAX_BYTES = parseInt(process.env.READCHUNKS_MAX_BYTES || '524288');
+
+const ZERO_HASH = '0'.repeat(64);
+
+/**
+ * Parse a single-range `Range: bytes=...` header against a file of `size`
+ * bytes. Returns null when the whole file should be sent.
+ */
+function parseRange(header: string | null, size: number): [number, number] | null | 'unsatisfiable' {
+  const match = header?.match(/^bytes=(\d*)-(\d*)$/);
+  if (!match || (!match[1] && !match[2])) return null;
+
+  let first: number;
+  let last: number;
+  if (!match[1]) {
+    // Suffix range: the last N bytes
+    first = Math.max(size - parseInt(match[2]), 0);
+    last = size - 1;
+  } else {
+    first = parseInt(match[1]);
+    last = match[2] ? Math.min(parseInt(match[2]), size - 1) : size - 1;
+  }
+  if (first > last || first >= size) return 'unsatisfiable';
+  return [first, last];
+}
+
 /**
- * Download a file's raw encrypted bytes by reassembling chunks from on-chain storage.
- * The client decrypts the data using their private key.
+ * Download a file's raw encrypted bytes, streamed from on-chain storage.
+ * Honours a single byte range. The client decrypts the data using their
+ * private key.
  */
 export const GET: APIRoute = async (context) => {
   try {
@@ -32,69 +63,120 @@ export const GET: APIRoute = async (context) => {
       });
     }
 
-    const fileId = parseInt(id);
-
-    // Get file metadata from blockchain
-    const fileResult = await getTableRows({
-      code: 'verarta.core',
-      scope: 'verarta.core',
-      table: 'artfiles',
-      key_type: 'i64',
-      lower_bound: id,
-      limit: 1,
-    });
-
-    if (fileResult.rows.length === 0 || String(fileResult.rows[0].file_id) !== id) {
-      return new Response(JSON.stringify({ error: 'File not found' }), {
-        status: 404,
-        headers: { 'Content-Type': 'application/json' },
-      });
+    // One read-only call gives the ordered chunk list (sizes, hashes, trace
+    // blocks), which maps byte ranges onto chunks
+    let manifest: any;
+    try {
+      manifest = await getFileManifest(id);
+    } catch (error) {
+      const message = String(error);
+      if (message.includes('file not found')) {
+        return new Response(JSON.stringify({ error: 'File not found' }), {
+          status: 404,
+          headers: { 'Content-Type': 'application/json' },
+        });
+      }
+      if (message.includes('file upload not complete')) {
+        return new Response(JSON.stringify({ error: 'File upload not complete' }), {
+          status: 400,
+          headers: { 'Content-Type': 'application/json' },
+        });
+      }
+      throw error;
     }
 
-    const fileMetadata = fileResult.rows[0] as any;
-
-    if (!fileMetadata.upload_complete) {
-      return new Response(JSON.stringify({ error: 'File upload not complete' }), {
-        status: 400,
-        headers: { 'Content-Type': 'application/json' },
+    // Chunk boundaries come from the manifest, so a byte range maps onto the
+    // chunks covering it without reading any chunk data
+    const chunkSizes: number[] = manifest.chunks.map((chunk: any) => Number(chunk.chunk_size));
+    const totalSize = chunkSizes.reduce((sum, size) => sum + size, 0);
+
+    const range = parseRange(context.request.headers.get('range'), totalSize);
+    if (range === 'unsatisfiable') {
+      return new Response(JSON.stringify({ error: 'Range not satisfiable' }), {
+        status: 416,
+        headers: {
+          'Content-Type': 'application/json',
+          'Content-Range': `bytes */${totalSize}`,
+        },
       });
     }
-
-    // Fetch all chunks from blockchain via byfile secondary index, ordered by chunk_index
-    const totalChunks = fileMetadata.total_chunks;
-    const chunkResult = await getTableRows({
-      code: 'verarta.core',
-      scope: 'verarta.core',
-      table: 'artchunks',
-      key_type: 'i64',
-      lower_bound: id,
-      upper_bound: (BigInt(id) + 1n).toString(),
-      limit: totalChunks,
-      index_position: 2, // byfile secondary index
-    });
-
-    const allChunks: Buffer[] = (chunkResult.rows as any[])
-      .sort((a, b) => a.chunk_index - b.chunk_index)
-      .map((chunk) => Buffer.from(chunk.chunk_data, 'base64'));
-
-    if (allChunks.length === 0) {
-      return new Response(JSON.stringify({ error: 'No chunks found' }), {
-        status: 404,
-        headers: { 'Content-Type': 'application/json' },
-      });
+    const [first, last] = range ?? [0, totalSize - 1];
+
+    const headers: Record<string, string> = {
+      'Content-Type': 'application/octet-stream',
+      'Content-Length': String(last - first + 1),
+      'Accept-Ranges': 'bytes',
+      'Cache-Control': 'public, max-age=31536000',
+    };
+    if (range) {
+      headers['Content-Range'] = `bytes ${first}-${last}/${totalSize}`;
+    }
+    const status = range ? 206 : 200;
+
+    if (manifest.storage_mode === 1) {
+      // Trace-only file: the manifest carries each chunk's receipt, and the
+      // data is rebuilt from the blocks they name. Duplicates of another file
+      // (addfile source_file_id) read its chunks.
+      const chunkMap = await getTraceChunks(String(manifest.chunk_scope), manifest.chunks);
+      if (chunkMap.size === 0) {
+        return new Response(JSON.stringify({ error: 'No chunks found' }), {
+          status: 404,
+          headers: { 'Content-Type': 'application/json' },
+        });
+      }
+      const fileBuffer = Buffer.concat(
+        [...chunkMap.entries()].sort((a, b) => a[0] - b[0]).map(([, buf]) => buf)
+      );
+      return new Response(fileBuffer.subarray(first, last + 1), { status, headers });
     }
 
-    const fileBuffer = Buffer.concat(allChunks);
+    // Table-stored file: stream readchunks pages covering [first, last]. The
+    // contract resolves shared chunk scopes and legacy artchunks rows itself.
+    let chunkIndex = 0;
+    let chunkStart = 0;
+    while (chunkStart + chunkSizes[chunkIndex] <= first) {
+      chunkStart += chunkSizes[chunkIndex++];
+    }
 
-    return new Response(fileBuffer, {
-      status: 200,
-      headers: {
-        'Content-Type': 'application/octet-stream',
-        'Content-Length': fileBuffer.length.toString(),
-        'Cache-Control': 'public, max-age=31536000',
+    const body = new ReadableStream<Uint8Array>({
+      async pull(controller) {
+        try {
+          const page = await callReadOnlyAction('readchunks', {
+            file_id: id,
+            start_index: chunkIndex,
+            max_bytes: READCHUNKS_MAX_BYTES,
+          });
+          const data = Buffer.from(page.data, 'hex');
+
+          let offset = 0;
+          for (; chunkIndex < page.next_chunk_index; chunkIndex++) {
+            const chunk = data.subarray(offset, offset + chunkSizes[chunkIndex]);
+            offset += chunkSizes[chunkIndex];
+
+            // Legacy rows carry no hash; everything else was hashed on upload
+            const expected = manifest.chunks[chunkIndex].chunk_hash;
+            if (expected !== ZERO_HASH && hashChunk(chunk).toString('hex') !== expected) {
+              throw new Error(`Chunk ${chunkIndex} of file ${id} failed its hash check`);
+            }
+
+            const from = Math.max(first - chunkStart, 0);
+            const to = Math.min(last + 1 - chunkStart, chunk.length);
+            controller.enqueue(chunk.subarray(from, to));
+            chunkStart += chunk.length;
+            if (chunkStart > last) {
+              controller.close();
+              return;
+            }
+          }
+        } catch (error) {
+          console.error('Download file stream error:', error);
+          controller.error(error);
+        }
       },
     });
 
+    return new Response(body, { status, headers });
+
   } catch (error) {
     console.error('Download file error:', error);
     return new Response(JSON.stringify({
@@ -1,8 +1,26 @@
 import type { APIRoute } from 'astro';
 import { requireAuth } from '../../../middleware/auth.js';
 import { getTableRows } from '../../../lib/antelope.js';
+import { Name } from '@wharfkit/antelope';
 import { query } from '../../../lib/db.js';
 
+// Rows written before the byownertime index existed only gain an entry once
+// the contract's reindex action has re-stored them. The flag never goes back
+// to false, so it is cached once seen.
+let ownerTimeIndexReady = false;
+
+async function isOwnerTimeIndexReady(): Promise<boolean> {
+  if (ownerTimeIndexReady) return true;
+  const result = await getTableRows({
+    code: 'verarta.core',
+    scope: 'verarta.core',
+    table: 'reindex',
+    limit: 1,
+  });
+  ownerTimeIndexReady = result.rows[0]?.done === true;
+  return ownerTimeIndexReady;
+}
+
 export const GET: APIRoute = async (context) => {
   try {
     const authResult = await requireAuth(context);
@@ -16,16 +34,37 @@ export const GET: APIRoute = async (context) => {
     const collectionId = url.searchParams.get('collection_id') || '';
     const era = url.searchParams.get('era')?.trim() || '';
 
-    // Query artworks by owner via secondary index.
-    const result = await getTableRows({
-      code: 'verarta.core',
-      scope: 'verarta.core',
-      table: 'artworks',
-      index_position: 2,
-      key_type: 'name',
-      lower_bound: user.blockchainAccount,
-      limit: 1000,
-    });
+    // Query the owner's artworks newest first via the (owner, created_at)
+    // byownertime index: the owner's rows are one contiguous i128 range.
+    // Until reindex is done, older rows are missing from it, so read byowner
+    // and sort here instead.
+    let result;
+    if (await isOwnerTimeIndexReady()) {
+      const ownerKey = BigInt(Name.from(user.blockchainAccount).value.toString()) << 64n;
+      result = await getTableRows({
+        code: 'verarta.core',
+        scope: 'verarta.core',
+        table: 'artworks',
+        index_position: 3,
+        key_type: 'i128',
+        lower_bound: ownerKey.toString(),
+        upper_bound: (ownerKey | 0xffffffffffffffffn).toString(),
+        limit: 1000,
+        reverse: true,
+      });
+    } else {
+      result = await getTableRows({
+        code: 'verarta.core',
+        scope: 'verarta.core',
+        table: 'artworks',
+        index_position: 2,
+        key_type: 'name',
+        lower_bound: user.blockchainAccount,
+        upper_bound: user.blockchainAccount,
+        limit: 1000,
+      });
+      result.rows.sort((a: any, b: any) => b.created_at - a.created_at);
+    }
 
     let filteredRows = result.rows.filter((row: any) => row.owner === user.blockchainAccount);
 
@@ -86,31 +125,47 @@ export const GET: APIRoute = async (context) => {
       }
     }
 
+    // Fetch the owner's completed files in one byowner range read instead of
+    // one byartwork read per artwork. The completed_files aggregate lets
+    // empty artworks (and listings with only those) skip it.
+    const filesByArtwork: Map<string, any[]> = new Map();
+    const needsFiles = rows.some((row: any) => row.completed_files === undefined || row.completed_files > 0);
+    if (needsFiles) {
+      try {
+        const fileResult = await getTableRows({
+          code: 'verarta.core',
+          scope: 'verarta.core',
+          table: 'artfiles',
+          index_position: 3,
+          key_type: 'name',
+          lower_bound: user.blockchainAccount,
+          upper_bound: user.blockchainAccount,
+          limit: 5000,
+        });
+        for (const f of fileResult.rows as any[]) {
+          if (!f.upload_complete) continue;
+          const key = String(f.artwork_id);
+          const list = filesByArtwork.get(key);
+          if (list) list.push(f); else filesByArtwork.set(key, [f]);
+        }
+      } catch {
+        // silently ignore — file info is best-effort
+      }
+    }
+
     const artworks = await Promise.all(
       rows.map(async (row: any) => {
-        // Fetch files for this artwork via secondary index (artwork_id)
-        let files: Array<{ id: string; mime_type: string }> = [];
-        try {
-          const fileResult = await getTableRows({
-            code: 'verarta.core',
-            scope: 'verarta.core',
-            table: 'artfiles',
-            index_position: 2,
-            key_type: 'i64',
-            lower_bound: row.artwork_id.toString(),
-            upper_bound: (BigInt(row.artwork_id) + 1n).toString(),
-            limit: 20,
-          });
-          const rows = (fileResult.rows as any[]).filter((f) => f.upload_complete);
-          // Thumbnail files first (they're the compact preview), then other image files
-          const thumbs = rows.filter((f) => f.is_thumbnail);
-          const images = rows.filter((f) => !f.is_thumbnail && f.mime_type?.startsWith('image/'));
-          const others = rows.filter((f) => !f.is_thumbnail && !f.mime_type?.startsWith('image/'));
-          const ordered = [...thumbs, ...images, ...others];
-          files = ordered.slice(0, 5).map((f) => ({ id: String(f.file_id), mime_type: f.mime_type }));
-        } catch {
-          // silently ignore — file info is best-effort
-        }
+        // Thumbnail files first (they're the compact preview; highest ID first,
+        // like the contract's thumbnail_file_id), then other image files
+        const fileRows = filesByArtwork.get(String(row.artwork_id)) ?? [];
+        const thumbs = fileRows
+          .filter((f) => f.is_thumbnail)
+          .sort((a, b) => Number(b.file_id) - Number(a.file_id));
+        const images = fileRows.filter((f) => !f.is_thumbnail && f.mime_type?.startsWith('image/'));
+        const others = fileRows.filter((f) => !f.is_thumbnail && !f.mime_type?.startsWith('image/'));
+        const ordered = [...thumbs, ...images, ...others];
+        const files: Array<{ id: string; mime_type: string }> =
+          ordered.slice(0, 5).map((f) => ({ id: String(f.file_id), mime_type: f.mime_type }));
 
         const extras = extrasMap.get(String(row.artwork_id));
 
@@ -120,6 +175,10 @@ export const GET: APIRoute = async (context) => {
           title: row._title,
           created_at: new Date(row.created_at * 1000).toISOString(),
           files,
+          file_count: row.file_count,
+          total_bytes: row.total_bytes ?? null,
+          completed_files: row.completed_files ?? null,
+          thumbnail_file_id: row.thumbnail_file_id ? String(row.thumbnail_file_id) : null,
           artist_name: extras?.artist_name ?? null,
           collection_name: extras?.collection_name ?? null,
           era: extras?.era ?? null,
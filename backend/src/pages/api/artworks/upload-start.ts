@@ -11,12 +11,22 @@ import {
   getChunkSize,
   readChunk,
   deleteTempFile,
+  hashChunk,
+  chunkMerkleRoot,
 } from '../../../lib/fileUpload.js';
 import { buildAndSignTransaction, CHAIN_CONFIG, chainClient } from '../../../lib/antelope.js';
 
+// Contract limit on total chunk bytes per uploadchunks action (MAX_CHUNK_BATCH_BYTES)
+const MAX_CHUNK_BATCH_BYTES = 491520;
+
+// The contract throttles chunk bytes per account with a token bucket
+// (1 MB/s by default); a rejected batch is retried once it has refilled
+const INGEST_RETRY_LIMIT = 10;
+const INGEST_RETRY_DELAY_MS = 1000;
+
 const UploadStartSchema = z.object({
   artwork_id: z.number().int().positive(),
-  file_id: z.number().int().positive(),
+  file_id: z.number().int().positive(), // addfile return value (allocated on-chain)
   title: z.string().max(255).default(''),
   filename: z.string().min(1).max(255),
   mime_type: z.string().min(1).max(100),
@@ -60,27 +70,13 @@ export const POST: APIRoute = async (context) => {
     const chunkSize = getChunkSize();
     const totalChunks = calculateTotalChunks(fileSize);
 
-    // Record upload in database
-    await query(
-      `INSERT INTO file_uploads (
-        user_id, upload_id, temp_file_path, original_filename,
-        mime_type, file_size, file_hash, chunk_size, total_chunks,
-        is_thumbnail, blockchain_artwork_id, blockchain_file_id, created_at
-      ) VALUES ($1, $2, $3, $4, $5, $6, $7, $8, $9, $10, $11, $12, NOW())
-      RETURNING id`,
-      [
-        user.userId, uploadId, tempFilePath, filename,
-        mime_type, fileSize, fileHash, chunkSize, totalChunks,
-        is_thumbnail, artwork_id, file_id,
-      ]
-    );
-
     const contractAccount = String(CHAIN_CONFIG.contractAccount);
     const ownerAccount = user.blockchainAccount;
 
     // Wait for the addfile transaction (pushed by frontend) to be included in a block.
     // The uploadchunk action requires the file to exist on-chain.
     const nodeUrl = process.env.HISTORY_NODE_URL || 'http://localhost:8888';
+    let fileRow: any = null;
     for (let attempt = 0; attempt < 15; attempt++) {
       try {
         const resp = await fetch(`${nodeUrl}/v1/chain/get_table_rows`, {
@@ -97,7 +93,10 @@ export const POST: APIRoute = async (context) => {
           }),
         });
         const result = await resp.json();
-        if (result.rows && result.rows.length > 0) break;
+        if (result.rows && result.rows.length > 0) {
+          fileRow = result.rows[0];
+          break;
+        }
       } catch {
         // retry
       }
@@ -105,7 +104,35 @@ export const POST: APIRoute = async (context) => {
       await new Promise((r) => setTimeout(r, 2000));
     }
 
-    // Helper: wait for uploaded_chunks to reach expected count on-chain
+    // file_id is the ID addfile returned to the browser; only push chunks
+    // for it if it names this user's file in the stated artwork
+    if (fileRow.owner !== ownerAccount || String(fileRow.artwork_id) !== String(artwork_id)) {
+      await deleteTempFile(tempFilePath);
+      return new Response(JSON.stringify({
+        error: 'File does not belong to this user and artwork',
+      }), {
+        status: 403,
+        headers: { 'Content-Type': 'application/json' },
+      });
+    }
+
+    // Record upload in database
+    await query(
+      `INSERT INTO file_uploads (
+        user_id, upload_id, temp_file_path, original_filename,
+        mime_type, file_size, file_hash, chunk_size, total_chunks,
+        is_thumbnail, blockchain_artwork_id, blockchain_file_id, created_at
+      ) VALUES ($1, $2, $3, $4, $5, $6, $7, $8, $9, $10, $11, $12, NOW())
+      RETURNING id`,
+      [
+        user.userId, uploadId, tempFilePath, filename,
+        mime_type, fileSize, fileHash, chunkSize, totalChunks,
+        is_thumbnail, artwork_id, file_id,
+      ]
+    );
+
+    // Helper: wait for uploaded_chunks to reach expected count on-chain.
+    // Until completefile, progress lives in the file's fileuploads row.
     async function waitForChunkCount(expectedCount: number): Promise<void> {
       for (let attempt = 0; attempt < 15; attempt++) {
         try {
@@ -116,7 +143,7 @@ export const POST: APIRoute = async (context) => {
               json: true,
               code: contractAccount,
               scope: contractAccount,
-              table: 'artfiles',
+              table: 'fileuploads',
               lower_bound: String(file_id),
               upper_bound: String(file_id),
               limit: 1,
@@ -132,40 +159,67 @@ export const POST: APIRoute = async (context) => {
       throw new Error(`Chunk count did not reach ${expectedCount} after 30s`);
     }
 
-    // Upload all chunks server-side using service key.
-    // With 5-second block intervals, each chunk must be confirmed before the next
-    // to avoid "file not found" or stale state errors.
-    for (let i = 0; i < totalChunks; i++) {
-      const chunkBuffer = await readChunk(tempFilePath, i);
-      const chunkDataB64 = chunkBuffer.toString('base64');
-      const chunkId = Date.now() * 1000 + i; // unique chunk ID
+    // Small thumbnails are inlined in addfile (contract max_inline_size) and
+    // arrive already complete, so there is nothing left to push
+    if (!fileRow.upload_complete) {
+      // Upload all chunks server-side using service key, packing as many
+      // consecutive chunks into each uploadchunks action as the contract's
+      // batch limit allows (one per action at the default 256KB chunk size).
+      // With 5-second block intervals, each batch must be confirmed before the next
+      // to avoid "file not found" or stale state errors.
+      const chunkHashes: Buffer[] = [];
+      for (let i = 0; i < totalChunks; ) {
+        const chunks: Array<Record<string, unknown>> = [];
+        let batchBytes = 0;
+        while (i < totalChunks) {
+          const size = Math.min(chunkSize, fileSize - i * chunkSize);
+          if (chunks.length > 0 && batchBytes + size > MAX_CHUNK_BATCH_BYTES) break;
 
-      await buildAndSignTransaction('uploadchunk', {
-        chunk_id: chunkId,
+          const chunkBuffer = await readChunk(tempFilePath, i);
+          chunkHashes.push(hashChunk(chunkBuffer));
+          chunks.push({
+            chunk_index: i,
+            chunk_data: chunkBuffer.toString('hex'), // ABI type `bytes`
+            chunk_size: chunkBuffer.length,
+          });
+          batchBytes += chunkBuffer.length;
+          i++;
+        }
+
+        for (let attempt = 0; ; attempt++) {
+          try {
+            await buildAndSignTransaction('uploadchunks', {
+              file_id,
+              owner: ownerAccount,
+              chunks,
+            });
+            break;
+          } catch (error) {
+            const throttled = String(error).includes('chunk ingest rate exceeded');
+            if (!throttled || attempt + 1 >= INGEST_RETRY_LIMIT) throw error;
+            await new Promise((r) => setTimeout(r, INGEST_RETRY_DELAY_MS));
+          }
+        }
+
+        // Wait for this batch to be confirmed on-chain before pushing the next
+        await waitForChunkCount(i);
+
+        // Track progress in database
+        await query(
+          `UPDATE file_uploads SET uploaded_chunks = $1 WHERE upload_id = $2`,
+          [i, uploadId]
+        );
+      }
+
+      // Complete the file on-chain (all chunks confirmed at this point)
+      await buildAndSignTransaction('completefile', {
         file_id,
         owner: ownerAccount,
-        chunk_index: i,
-        chunk_data: chunkDataB64,
-        chunk_size: chunkBuffer.length,
+        total_chunks: totalChunks,
+        merkle_root: chunkMerkleRoot(chunkHashes).toString('hex'),
       });
-
-      // Wait for this chunk to be confirmed on-chain before pushing the next
-      await waitForChunkCount(i + 1);
-
-      // Track progress in database
-      await query(
-        `UPDATE file_uploads SET uploaded_chunks = $1 WHERE upload_id = $2`,
-        [i + 1, uploadId]
-      );
     }
 
-    // Complete the file on-chain (all chunks confirmed at this point)
-    await buildAndSignTransaction('completefile', {
-      file_id,
-      owner: ownerAccount,
-      total_chunks: totalChunks,
-    });
-
     // Mark upload complete in database
     await query(
       `UPDATE file_uploads SET completed_at = NOW() WHERE upload_id = $1`,
@@ -0,0 +1,405 @@
+/**
+ * Native benchmark suite for verarta.core
+ *
+ * Runs the contract's actions against the in-memory stand-ins in
+ * include/eosio and reports, per action and table size:
+ *   - host CPU time per call (a relative measure; WASM on a producer is slower)
+ *   - rows read and written per call
+ *   - net RAM bytes billed per call (chain billable sizes, including index
+ *     rows), and for each table the action added rows to, rows added per
+ *     call and RAM billed per added row
+ *
+ * Each benchmark checks afterwards that its calls took effect and exits
+ * nonzero if they did not.
+ *
+ * Usage: verarta_core_bench [rows ...]   (default: 10000 100000 1000000)
+ */
+
+#include "verarta.core.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <map>
+#include <string>
+#include <vector>
+
+using namespace eosio;
+using namespace verarta;
+
+namespace {
+
+constexpr name contract_account = "verarta.core"_n;
+constexpr name bench_owner = "alice"_n;
+constexpr name bench_recipient = "bob"_n;
+constexpr name filler_owner = "filler"_n;
+
+constexpr uint32_t bench_time = 1760000000;        // 2025-10-09, fixed for reproducible quota windows
+constexpr uint32_t background_chunks_per_file = 16;
+
+/**
+ * Aggregated cost of a run of identical action calls
+ */
+struct result {
+   const char* action;
+   uint64_t table_rows;
+   uint32_t calls;
+   double us_per_call;
+   double reads_per_call;
+   double writes_per_call;
+   double ram_per_call;                    // Net RAM delta, erases included
+   std::map<name, native::table_emplaces> emplaces; // Totals over all calls
+};
+
+native::chain_state& chain() {
+   return native::chain_state::get();
+}
+
+verartatoken make_contract() {
+   static const char empty[1] = {};
+   return verartatoken(contract_account, contract_account, datastream<const char*>(empty, 0));
+}
+
+/**
+ * Time `calls` invocations of fn(i) and collect the table counters they
+ * produced. Everything fn does is timed, so keep setup out of it.
+ */
+template <typename F>
+result measure(const char* action, uint64_t table_rows, uint32_t calls, F&& fn) {
+   chain().take_counters();
+   auto start = std::chrono::steady_clock::now();
+   for (uint32_t i = 0; i < calls; ++i) {
+      fn(i);
+   }
+   auto elapsed = std::chrono::steady_clock::now() - start;
+   native::usage used = chain().take_counters();
+
+   double us = std::chrono::duration<double, std::micro>(elapsed).count();
+   return result{
+      action,
+      table_rows,
+      calls,
+      us / calls,
+      double(used.rows_read) / calls,
+      double(used.rows_written) / calls,
+      double(used.ram_delta) / calls,
+      std::move(used.emplaces),
+   };
+}
+
+void reset_chain() {
+   chain().reset_tables();
+   chain().set_time(bench_time);
+   chain().take_counters();
+}
+
+/**
+ * Fill artworks and artfiles with `rows` rows each, owned by another account,
+ * so lookups run against a table of realistic size
+ */
+void populate_artworks(uint64_t rows) {
+   verartatoken::artworks_table artworks(contract_account, contract_account.value);
+   verartatoken::artfiles_table artfiles(contract_account, contract_account.value);
+
+   for (uint64_t id = 1; id <= rows; ++id) {
+      artworks.emplace(filler_owner, [&](auto& row) {
+         row.artwork_id = id;
+         row.owner = filler_owner;
+         row.title_encrypted = "title";
+         row.description_encrypted = "description";
+         row.metadata_encrypted = "metadata";
+         row.creator_public_key = "key";
+         row.file_count = 1;
+         row.created_at = bench_time;
+         row.deleting.emplace(false);
+      });
+      artfiles.emplace(filler_owner, [&](auto& row) {
+         row.file_id = id;
+         row.artwork_id = id;
+         row.owner = filler_owner;
+         row.filename_encrypted = "name";
+         row.mime_type = "image/png";
+         row.file_size = 262144;
+         row.encrypted_dek = "dek";
+         row.iv = "iv";
+         row.auth_tag = "tag";
+         row.total_chunks = background_chunks_per_file;
+         row.uploaded_chunks = background_chunks_per_file;
+         row.upload_complete = true;
+         row.created_at = bench_time;
+         row.completed_at = bench_time;
+      });
+   }
+   chain().take_counters();
+}
+
+/**
+ * Fill filechunks with `rows` small rows spread over the background files
+ */
+void populate_chunks(uint64_t rows) {
+   std::vector<char> data(64, 'x');
+   for (uint64_t n = 0; n < rows; ++n) {
+      verartatoken::filechunks_table chunks(contract_account, 1 + n / background_chunks_per_file);
+      chunks.emplace(filler_owner, [&](auto& row) {
+         row.chunk_index = uint32_t(n % background_chunks_per_file);
+         row.chunk_size = data.size();
+         row.uploaded_at = bench_time;
+         row.chunk_data = data;
+      });
+   }
+   chain().take_counters();
+}
+
+void unlimited_quota(verartatoken& c, name account) {
+   chain().set_auth({contract_account});
+   uint64_t unlimited = ~uint64_t(0) >> 1;
+   c.setquota(account, 1, 1000000000, unlimited, 1000000000, unlimited,
+              binary_extension<uint64_t>(unlimited), binary_extension<uint64_t>(unlimited));
+}
+
+uint64_t new_artwork(verartatoken& c) {
+   chain().set_auth({bench_owner});
+   return c.createart(0, bench_owner, std::string(64, 't'), std::string(256, 'd'),
+                      std::string(512, 'm'), std::string(44, 'k'));
+}
+
+uint64_t new_file(verartatoken& c, uint64_t artwork_id, uint64_t file_size) {
+   chain().set_auth({bench_owner});
+   return c.addfile(0, artwork_id, bench_owner, std::string(64, 'f'), "image/png", file_size,
+                    checksum256(), std::string(88, 'k'), {}, std::string(16, 'i'),
+                    std::string(44, 'a'), false, {}, {}, {});
+}
+
+// ---------- Benchmarks ----------
+
+result bench_createart(uint64_t rows) {
+   reset_chain();
+   populate_artworks(rows);
+   verartatoken c = make_contract();
+   chain().set_auth({bench_owner});
+
+   std::vector<uint64_t> ids;
+   ids.reserve(1000);
+   result r = measure("createart", rows, 1000, [&](uint32_t) {
+      ids.push_back(new_artwork(c));
+   });
+
+   verartatoken::artworks_table artworks(contract_account, contract_account.value);
+   for (uint64_t id : ids) {
+      auto itr = artworks.find(id);
+      check(itr != artworks.end() && itr->owner == bench_owner, "createart: artwork not created");
+   }
+   return r;
+}
+
+result bench_addfile(uint64_t rows) {
+   reset_chain();
+   populate_artworks(rows);
+   verartatoken c = make_contract();
+   unlimited_quota(c, bench_owner);
+   uint64_t artwork_id = new_artwork(c);
+
+   std::vector<uint64_t> ids;
+   ids.reserve(1000);
+   result r = measure("addfile", rows, 1000, [&](uint32_t) {
+      ids.push_back(new_file(c, artwork_id, DEFAULT_MAX_CHUNK_SIZE));
+   });
+
+   verartatoken::artfiles_table artfiles(contract_account, contract_account.value);
+   for (uint64_t id : ids) {
+      auto itr = artfiles.find(id);
+      check(itr != artfiles.end() && itr->artwork_id == artwork_id, "addfile: file not created");
+   }
+   verartatoken::artworks_table artworks(contract_account, contract_account.value);
+   check(artworks.get(artwork_id).file_count == ids.size(), "addfile: file_count not updated");
+   return r;
+}
+
+result bench_uploadchunk(uint64_t rows) {
+   // populate_chunks fills the scopes of files 1..ceil(rows / 16); create
+   // all of them so the file allocated below gets a fresh scope
+   reset_chain();
+   populate_artworks((rows + background_chunks_per_file - 1) / background_chunks_per_file);
+   populate_chunks(rows);
+   verartatoken c = make_contract();
+   unlimited_quota(c, bench_owner);
+
+   const uint32_t calls = 128;
+   uint64_t artwork_id = new_artwork(c);
+   uint64_t file_id = new_file(c, artwork_id, uint64_t(calls) * DEFAULT_MAX_CHUNK_SIZE);
+   std::vector<char> data(DEFAULT_MAX_CHUNK_SIZE, 'c');
+
+   chain().set_auth({contract_account});
+   result r = measure("uploadchunk", rows, calls, [&](uint32_t i) {
+      c.uploadchunk(file_id, bench_owner, i, data, DEFAULT_MAX_CHUNK_SIZE);
+   });
+
+   verartatoken::fileuploads_table uploads(contract_account, contract_account.value);
+   auto progress = uploads.find(file_id);
+   check(progress != uploads.end() && progress->uploaded_chunks == calls, "uploadchunk: chunks not recorded");
+   return r;
+}
+
+result bench_getmanifest(uint64_t rows) {
+   reset_chain();
+   populate_artworks(rows);
+   verartatoken c = make_contract();
+   unlimited_quota(c, bench_owner);
+
+   // One full manifest page of 64KB chunks. The file is marked complete
+   // through the table: completefile's root check is not what is measured.
+   const uint32_t chunks = MAX_MANIFEST_CHUNKS;
+   std::vector<char> data(65536, 'c');
+   uint64_t artwork_id = new_artwork(c);
+   uint64_t file_id = new_file(c, artwork_id, uint64_t(chunks) * data.size());
+   chain().set_auth({contract_account});
+   for (uint32_t i = 0; i < chunks; ++i) {
+      c.uploadchunk(file_id, bench_owner, i, data, data.size());
+   }
+   verartatoken::artfiles_table artfiles(contract_account, contract_account.value);
+   artfiles.modify(artfiles.find(file_id), same_payer, [&](auto& row) {
+      row.total_chunks = chunks;
+      row.uploaded_chunks = chunks;
+      row.upload_complete = true;
+   });
+
+   verartatoken::filemanifest manifest;
+   result r = measure("getmanifest", rows, 100, [&](uint32_t) {
+      manifest = c.getmanifest(file_id, bench_owner, 0);
+   });
+
+   check(manifest.file_id == file_id && manifest.chunks.size() == chunks &&
+         manifest.next_chunk_index == chunks,
+         "getmanifest: incomplete manifest");
+   return r;
+}
+
+result bench_deleteart(uint64_t rows) {
+   reset_chain();
+   populate_artworks(rows);
+   verartatoken c = make_contract();
+   unlimited_quota(c, bench_owner);
+
+   // Artworks of 4 files x 64 chunks; each takes several budgeted calls
+   const uint32_t artworks = 5;
+   const uint32_t files = 4;
+   const uint32_t chunks = 64;
+   std::vector<char> data(1024, 'c');
+   std::vector<uint64_t> artwork_ids;
+   for (uint32_t a = 0; a < artworks; ++a) {
+      uint64_t artwork_id = new_artwork(c);
+      for (uint32_t f = 0; f < files; ++f) {
+         uint64_t file_id = new_file(c, artwork_id, chunks * data.size());
+         for (uint32_t i = 0; i < chunks; ++i) {
+            c.uploadchunk(file_id, bench_owner, i, data, data.size());
+         }
+      }
+      artwork_ids.push_back(artwork_id);
+   }
+
+   // Calls needed per artwork depend on the row budget, so time the whole
+   // sweep and count calls as they happen
+   chain().set_auth({bench_owner});
+   uint32_t calls = 0;
+   result r = measure("deleteart", rows, 1, [&](uint32_t) {
+      for (uint64_t artwork_id : artwork_ids) {
+         do {
+            ++calls;
+         } while (!c.deleteart(artwork_id, bench_owner));
+      }
+   });
+   r.calls = calls;
+   r.us_per_call /= calls;
+   r.reads_per_call /= calls;
+   r.writes_per_call /= calls;
+   r.ram_per_call /= calls;
+
+   verartatoken::artworks_table table(contract_account, contract_account.value);
+   for (uint64_t artwork_id : artwork_ids) {
+      check(table.find(artwork_id) == table.end(), "deleteart: artwork not erased");
+   }
+   return r;
+}
+
+result bench_transferart(uint64_t rows) {
+   reset_chain();
+   populate_artworks(rows);
+   verartatoken c = make_contract();
+   unlimited_quota(c, bench_owner);
+
+   const uint32_t files = 4;
+   uint64_t artwork_id = new_artwork(c);
+   std::vector<uint64_t> file_ids;
+   for (uint32_t f = 0; f < files; ++f) {
+      file_ids.push_back(new_file(c, artwork_id, DEFAULT_MAX_CHUNK_SIZE));
+   }
+   std::vector<std::string> deks(files, std::string(88, 'k'));
+   std::vector<std::string> tags(files, std::string(44, 'a'));
+
+   // Hand the artwork back and forth so every call does the same work.
+   // A call that left the owner unchanged fails the next one's owner check,
+   // so only the last call needs checking afterwards.
+   const uint32_t calls = 1001;
+   result r = measure("transferart", rows, calls, [&](uint32_t i) {
+      name from = i % 2 ? bench_recipient : bench_owner;
+      name to = i % 2 ? bench_owner : bench_recipient;
+      chain().set_auth({from});
+      c.transferart(artwork_id, from, to, file_ids, deks, tags, "");
+   });
+
+   verartatoken::artworks_table artworks(contract_account, contract_account.value);
+   verartatoken::artfiles_table artfiles(contract_account, contract_account.value);
+   check(artworks.get(artwork_id).owner == bench_recipient, "transferart: artwork not transferred");
+   for (uint64_t file_id : file_ids) {
+      check(artfiles.get(file_id).owner == bench_recipient, "transferart: file not transferred");
+   }
+   return r;
+}
+
+void print_header() {
+   std::printf("%-12s %10s %6s %12s %10s %10s %12s\n",
+               "action", "rows", "calls", "us/call", "reads", "writes", "RAM B/call");
+}
+
+/**
+ * One line per action, then one indented line per table it added rows to:
+ * rows added per call and RAM billed per added row
+ */
+void print_result(const result& r) {
+   std::printf("%-12s %10llu %6u %12.2f %10.1f %10.1f %12.1f\n",
+               r.action, (unsigned long long)r.table_rows, r.calls, r.us_per_call,
+               r.reads_per_call, r.writes_per_call, r.ram_per_call);
+   for (const auto& [table, added] : r.emplaces) {
+      std::printf("  + %-12s %8.2f rows/call %10.1f B/row\n",
+                  table.to_string().c_str(), double(added.rows) / r.calls,
+                  double(added.ram) / added.rows);
+   }
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+   std::vector<uint64_t> sizes;
+   for (int i = 1; i < argc; ++i) {
+      sizes.push_back(std::strtoull(argv[i], nullptr, 10));
+   }
+   if (sizes.empty()) {
+      sizes = {10000, 100000, 1000000};
+   }
+
+   print_header();
+   try {
+      for (uint64_t rows : sizes) {
+         print_result(bench_createart(rows));
+         print_result(bench_addfile(rows));
+         print_result(bench_uploadchunk(rows));
+         print_result(bench_getmanifest(rows));
+         print_result(bench_deleteart(rows));
+         print_result(bench_transferart(rows));
+      }
+   } catch (const eosio_assert_exception& e) {
+      std::fprintf(stderr, "assertion failed: %s\n", e.what());
+      return 1;
+   }
+   return 0;
+}
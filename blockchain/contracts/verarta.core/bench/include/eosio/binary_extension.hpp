@@ -0,0 +1,57 @@
+#pragma once
+
+#include <optional>
+#include <type_traits>
+#include <utility>
+
+#include "check.hpp"
+
+namespace eosio {
+
+/**
+ * Native stand-in for eosio::binary_extension: an optional trailing field that
+ * older serialized rows simply do not carry
+ */
+template <typename T>
+class binary_extension {
+public:
+   using value_type = T;
+
+   constexpr binary_extension() = default;
+   constexpr binary_extension(const T& v) : _v(v) {}
+   constexpr binary_extension(T&& v) : _v(std::move(v)) {}
+
+   constexpr bool has_value() const { return _v.has_value(); }
+
+   T& value() & {
+      check(_v.has_value(), "cannot get value of empty binary_extension");
+      return *_v;
+   }
+   const T& value() const & {
+      check(_v.has_value(), "cannot get value of empty binary_extension");
+      return *_v;
+   }
+
+   // Same shape as the CDT: the defaulting overload binds an lvalue
+   // reference, so value_or() (value-initialized default) is the usual form.
+   template <typename U>
+   auto value_or(U&& def) -> std::enable_if_t<std::is_convertible<U, T&>::value, T&> {
+      return _v.has_value() ? *_v : static_cast<T&>(def);
+   }
+   T value_or() const { return _v.has_value() ? *_v : T{}; }
+
+   template <typename... Args>
+   T& emplace(Args&&... args) { return _v.emplace(std::forward<Args>(args)...); }
+
+   void reset() { _v.reset(); }
+
+   T& operator*() & { return value(); }
+   const T& operator*() const & { return value(); }
+   T* operator->() { return &value(); }
+   const T* operator->() const { return &value(); }
+
+private:
+   std::optional<T> _v;
+};
+
+} // namespace eosio
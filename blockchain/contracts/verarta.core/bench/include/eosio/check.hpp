@@ -0,0 +1,23 @@
+#pragma once
+
+#include <stdexcept>
+#include <string>
+
+namespace eosio {
+
+/**
+ * Thrown by the native check(); mirrors eosio_assert aborting the transaction
+ */
+struct eosio_assert_exception : std::runtime_error {
+   using std::runtime_error::runtime_error;
+};
+
+inline void check(bool pred, const char* msg) {
+   if (!pred) throw eosio_assert_exception(msg);
+}
+
+inline void check(bool pred, const std::string& msg) {
+   if (!pred) throw eosio_assert_exception(msg);
+}
+
+} // namespace eosio
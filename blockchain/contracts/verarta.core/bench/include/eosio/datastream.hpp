@@ -0,0 +1,80 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include "binary_extension.hpp"
+#include "crypto.hpp"
+#include "name.hpp"
+#include "reflect.hpp"
+#include "time.hpp"
+
+namespace eosio {
+
+/**
+ * Minimal datastream; the native build only needs it to satisfy the
+ * contract constructor signature
+ */
+template <typename T>
+class datastream {
+public:
+   datastream(T start, size_t s) : _start(start), _pos(start), _end(start + s) {}
+   size_t remaining() const { return _end - _pos; }
+private:
+   T _start;
+   T _pos;
+   T _end;
+};
+
+namespace native {
+
+inline size_t varuint32_size(uint64_t v) {
+   size_t n = 0;
+   do { v >>= 7; ++n; } while (v);
+   return n;
+}
+
+template <typename T> size_t pack_size(const T& v);
+
+inline size_t pack_size_impl(const name&) { return 8; }
+inline size_t pack_size_impl(const checksum256&) { return 32; }
+inline size_t pack_size_impl(const time_point&) { return 8; }
+inline size_t pack_size_impl(const time_point_sec&) { return 4; }
+inline size_t pack_size_impl(const block_timestamp&) { return 4; }
+inline size_t pack_size_impl(const std::string& s) { return varuint32_size(s.size()) + s.size(); }
+
+template <typename T>
+size_t pack_size_impl(const std::vector<T>& v) {
+   if constexpr (std::is_arithmetic_v<T>) {
+      return varuint32_size(v.size()) + v.size() * sizeof(T);
+   } else {
+      size_t total = varuint32_size(v.size());
+      for (const auto& e : v) total += pack_size(e);
+      return total;
+   }
+}
+
+template <typename T>
+size_t pack_size_impl(const binary_extension<T>& v) {
+   return v.has_value() ? pack_size(v.value()) : 0;
+}
+
+template <typename T>
+size_t pack_size(const T& v) {
+   if constexpr (std::is_arithmetic_v<T> || std::is_enum_v<T>) {
+      return sizeof(T);
+   } else if constexpr (std::is_aggregate_v<T>) {
+      size_t total = 0;
+      for_each_field(const_cast<T&>(v), [&](const auto& field) { total += pack_size(field); });
+      return total;
+   } else {
+      return pack_size_impl(v);
+   }
+}
+
+} // namespace native
+
+} // namespace eosio
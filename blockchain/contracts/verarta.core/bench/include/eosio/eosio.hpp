@@ -0,0 +1,17 @@
+#pragma once
+
+// Native (host) stand-in for the CDT umbrella header. Only what verarta.core
+// uses is provided; actions are invoked directly rather than dispatched.
+
+#include "binary_extension.hpp"
+#include "check.hpp"
+#include "contract.hpp"
+#include "crypto.hpp"
+#include "datastream.hpp"
+#include "multi_index.hpp"
+#include "name.hpp"
+#include "native.hpp"
+#include "system.hpp"
+#include "time.hpp"
+
+#define EOSIO_DISPATCH(...)
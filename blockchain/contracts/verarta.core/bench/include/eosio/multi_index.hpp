@@ -0,0 +1,421 @@
+#pragma once
+
+#include <cstdint>
+#include <iterator>
+#include <map>
+#include <set>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+#include "check.hpp"
+#include "crypto.hpp"
+#include "datastream.hpp"
+#include "name.hpp"
+#include "native.hpp"
+
+namespace eosio {
+
+constexpr name same_payer{};
+
+template <class Class, typename Type, Type (Class::*PtrToMemberFunction)() const>
+struct const_mem_fun {
+   using result_type = Type;
+   Type operator()(const Class& c) const { return (c.*PtrToMemberFunction)(); }
+};
+
+template <name::raw IndexName, typename Extractor>
+struct indexed_by {
+   static constexpr name index_name = name(IndexName);
+   using secondary_extractor_type = Extractor;
+};
+
+namespace native {
+
+template <typename K>
+constexpr int64_t index_overhead() {
+   if constexpr (sizeof(K) <= 8) return index64_overhead_bytes;
+   else if constexpr (sizeof(K) == 16) return index128_overhead_bytes;
+   else return index128_overhead_bytes + 16;
+}
+
+} // namespace native
+
+/**
+ * In-memory multi_index with the same iteration and ordering semantics as the
+ * chain database: rows keyed by primary key per (code, scope), secondary
+ * indexes ordered by (secondary key, primary key).
+ */
+template <name::raw TableName, typename T, typename... Indices>
+class multi_index {
+   template <typename Extractor>
+   using key_of = std::decay_t<decltype(Extractor{}(std::declval<const T&>()))>;
+
+   template <typename Index>
+   using index_set = std::set<std::pair<key_of<typename Index::secondary_extractor_type>, uint64_t>>;
+
+   struct table_data {
+      std::map<uint64_t, T> rows;
+      std::tuple<index_set<Indices>...> indices;
+   };
+
+   using store_type = std::map<std::pair<uint64_t, uint64_t>, table_data>;
+
+   static store_type& store() {
+      static store_type* s = [] {
+         auto* p = new store_type();
+         native::chain_state::get().resets.push_back([p] { p->clear(); });
+         return p;
+      }();
+      return *s;
+   }
+
+   static int64_t billable_size(const T& obj) {
+      return native::row_overhead_bytes + int64_t(native::pack_size(obj)) +
+             (int64_t(0) + ... + native::index_overhead<key_of<typename Indices::secondary_extractor_type>>());
+   }
+
+   table_data& data() const {
+      auto& s = store();
+      auto it = s.find({_code.value, _scope});
+      if (it == s.end()) {
+         it = s.emplace(std::make_pair(_code.value, _scope), table_data{}).first;
+      }
+      return it->second;
+   }
+
+   template <size_t... I>
+   void index_insert(table_data& d, const T& obj, std::index_sequence<I...>) const {
+      (std::get<I>(d.indices).emplace(
+         typename std::tuple_element_t<I, std::tuple<Indices...>>::secondary_extractor_type{}(obj),
+         obj.primary_key()), ...);
+   }
+
+   template <size_t... I>
+   void index_remove(table_data& d, const T& obj, std::index_sequence<I...>) const {
+      (std::get<I>(d.indices).erase(std::make_pair(
+         typename std::tuple_element_t<I, std::tuple<Indices...>>::secondary_extractor_type{}(obj),
+         obj.primary_key())), ...);
+   }
+
+   template <size_t... I>
+   static auto index_keys(const T& obj, std::index_sequence<I...>) {
+      return std::make_tuple(
+         typename std::tuple_element_t<I, std::tuple<Indices...>>::secondary_extractor_type{}(obj)...);
+   }
+
+   // Re-key only the indexes whose secondary key changed, so iterators into
+   // the others stay valid across modify() as they do on chain
+   template <typename Keys, size_t... I>
+   void index_update(table_data& d, const Keys& old_keys, const T& obj, std::index_sequence<I...>) const {
+      uint64_t pk = obj.primary_key();
+      // Unused when the table has no secondary indexes
+      [[maybe_unused]] auto update = [&](auto& set, const auto& old_key, const auto& new_key) {
+         if (old_key == new_key) return;
+         set.erase(std::make_pair(old_key, pk));
+         set.emplace(new_key, pk);
+      };
+      (update(std::get<I>(d.indices), std::get<I>(old_keys),
+              typename std::tuple_element_t<I, std::tuple<Indices...>>::secondary_extractor_type{}(obj)), ...);
+   }
+
+   static void count_read() { ++native::chain_state::get().counters.rows_read; }
+   static void count_write(int64_t ram) {
+      auto& c = native::chain_state::get().counters;
+      ++c.rows_written;
+      c.ram_delta += ram;
+   }
+   static void count_emplace(int64_t ram) {
+      count_write(ram);
+      auto& t = native::chain_state::get().counters.emplaces[name(TableName)];
+      ++t.rows;
+      t.ram += ram;
+   }
+
+public:
+   class const_iterator {
+   public:
+      using iterator_category = std::bidirectional_iterator_tag;
+      using value_type = const T;
+      using difference_type = std::ptrdiff_t;
+      using pointer = const T*;
+      using reference = const T&;
+
+      const_iterator() = default;
+
+      const T& operator*() const { return _it->second; }
+      const T* operator->() const { return &_it->second; }
+
+      const_iterator& operator++() {
+         ++_it;
+         if (_it != _rows->end()) count_read();
+         return *this;
+      }
+      const_iterator operator++(int) { auto tmp = *this; ++(*this); return tmp; }
+      const_iterator& operator--() {
+         --_it;
+         count_read();
+         return *this;
+      }
+      const_iterator operator--(int) { auto tmp = *this; --(*this); return tmp; }
+
+      friend bool operator==(const const_iterator& a, const const_iterator& b) { return a._it == b._it; }
+      friend bool operator!=(const const_iterator& a, const const_iterator& b) { return a._it != b._it; }
+
+   private:
+      friend class multi_index;
+      using base = typename std::map<uint64_t, T>::iterator;
+      const_iterator(std::map<uint64_t, T>* rows, base it) : _rows(rows), _it(it) {}
+      std::map<uint64_t, T>* _rows = nullptr;
+      base _it;
+   };
+
+   using const_reverse_iterator = std::reverse_iterator<const_iterator>;
+
+   template <size_t I>
+   class index {
+      using index_type = std::tuple_element_t<I, std::tuple<Indices...>>;
+      using extractor = typename index_type::secondary_extractor_type;
+      using secondary_key_type = key_of<extractor>;
+      using set_type = index_set<index_type>;
+
+   public:
+      class const_iterator {
+      public:
+         using iterator_category = std::bidirectional_iterator_tag;
+         using value_type = const T;
+         using difference_type = std::ptrdiff_t;
+         using pointer = const T*;
+         using reference = const T&;
+
+         const_iterator() = default;
+
+         const T& operator*() const { return _data->rows.at(_it->second); }
+         const T* operator->() const { return &_data->rows.at(_it->second); }
+
+         const_iterator& operator++() {
+            ++_it;
+            if (_it != std::get<I>(_data->indices).end()) count_read();
+            return *this;
+         }
+         const_iterator operator++(int) { auto tmp = *this; ++(*this); return tmp; }
+         const_iterator& operator--() {
+            --_it;
+            count_read();
+            return *this;
+         }
+         const_iterator operator--(int) { auto tmp = *this; --(*this); return tmp; }
+
+         friend bool operator==(const const_iterator& a, const const_iterator& b) { return a._it == b._it; }
+         friend bool operator!=(const const_iterator& a, const const_iterator& b) { return a._it != b._it; }
+
+      private:
+         friend class index;
+         using base = typename set_type::const_iterator;
+         const_iterator(table_data* d, base it) : _data(d), _it(it) {}
+         table_data* _data = nullptr;
+         base _it;
+      };
+
+      explicit index(const multi_index* mi) : _mi(mi) {}
+
+      const_iterator begin() const { return wrap(set().begin()); }
+      const_iterator end() const { return const_iterator(&_mi->data(), set().end()); }
+
+      const_iterator lower_bound(const secondary_key_type& k) const {
+         return wrap(set().lower_bound(std::make_pair(k, uint64_t(0))));
+      }
+
+      const_iterator upper_bound(const secondary_key_type& k) const {
+         return wrap(set().upper_bound(std::make_pair(k, ~uint64_t(0))));
+      }
+
+      const_iterator find(const secondary_key_type& k) const {
+         auto itr = lower_bound(k);
+         if (itr != end() && extractor{}(*itr) == k) return itr;
+         return end();
+      }
+
+      const T& get(const secondary_key_type& k, const char* msg = "unable to find secondary key") const {
+         auto itr = find(k);
+         check(itr != end(), msg);
+         return *itr;
+      }
+
+      const_iterator iterator_to(const T& obj) const {
+         auto it = set().find(std::make_pair(extractor{}(obj), obj.primary_key()));
+         check(it != set().end(), "object passed to iterator_to is not in multi_index");
+         return const_iterator(&_mi->data(), it);
+      }
+
+      template <typename Lambda>
+      void modify(const_iterator itr, name payer, Lambda&& updater) {
+         const_cast<multi_index*>(_mi)->modify(*itr, payer, std::forward<Lambda>(updater));
+      }
+
+      const_iterator erase(const_iterator itr) {
+         check(itr != end(), "cannot pass end iterator to erase");
+         auto next = itr;
+         ++next;
+         uint64_t next_pk = 0;
+         bool has_next = next != end();
+         secondary_key_type next_key{};
+         if (has_next) {
+            next_key = next._it->first;
+            next_pk = next._it->second;
+         }
+         const_cast<multi_index*>(_mi)->erase(*itr);
+         if (!has_next) return end();
+         return const_iterator(&_mi->data(), set().find(std::make_pair(next_key, next_pk)));
+      }
+
+   private:
+      set_type& set() const { return std::get<I>(_mi->data().indices); }
+
+      const_iterator wrap(typename set_type::const_iterator it) const {
+         if (it != set().end()) count_read();
+         return const_iterator(&_mi->data(), it);
+      }
+
+      const multi_index* _mi;
+   };
+
+   multi_index(name code, uint64_t scope) : _code(code), _scope(scope) {}
+
+   name get_code() const { return _code; }
+   uint64_t get_scope() const { return _scope; }
+
+   const_iterator begin() const {
+      auto& rows = data().rows;
+      if (!rows.empty()) count_read();
+      return const_iterator(&rows, rows.begin());
+   }
+   const_iterator end() const {
+      auto& rows = data().rows;
+      return const_iterator(&rows, rows.end());
+   }
+   const_reverse_iterator rbegin() const { return const_reverse_iterator(end()); }
+   const_reverse_iterator rend() const { return const_reverse_iterator(begin()); }
+
+   const_iterator find(uint64_t pk) const {
+      auto& rows = data().rows;
+      auto it = rows.find(pk);
+      if (it != rows.end()) count_read();
+      return const_iterator(&rows, it);
+   }
+
+   const_iterator require_find(uint64_t pk, const char* msg = "unable to find key") const {
+      auto itr = find(pk);
+      check(itr != end(), msg);
+      return itr;
+   }
+
+   const T& get(uint64_t pk, const char* msg = "unable to find key") const {
+      return *require_find(pk, msg);
+   }
+
+   const_iterator lower_bound(uint64_t pk) const {
+      auto& rows = data().rows;
+      auto it = rows.lower_bound(pk);
+      if (it != rows.end()) count_read();
+      return const_iterator(&rows, it);
+   }
+
+   const_iterator upper_bound(uint64_t pk) const {
+      auto& rows = data().rows;
+      auto it = rows.upper_bound(pk);
+      if (it != rows.end()) count_read();
+      return const_iterator(&rows, it);
+   }
+
+   uint64_t available_primary_key() const {
+      auto& rows = data().rows;
+      if (rows.empty()) return 0;
+      return rows.rbegin()->first + 1;
+   }
+
+   const_iterator iterator_to(const T& obj) const {
+      auto& rows = data().rows;
+      auto it = rows.find(obj.primary_key());
+      check(it != rows.end(), "object passed to iterator_to is not in multi_index");
+      return const_iterator(&rows, it);
+   }
+
+   template <name::raw IndexName>
+   auto get_index() const {
+      constexpr size_t pos = index_position<IndexName, 0, Indices...>();
+      static_assert(pos < sizeof...(Indices), "name provided is not the name of any secondary index within multi_index");
+      return index<pos>(this);
+   }
+
+   template <typename Lambda>
+   const_iterator emplace(name payer, Lambda&& constructor) {
+      check(payer.value != 0, "cannot set payer to self when emplacing");
+      T obj{};
+      constructor(obj);
+      auto& d = data();
+      uint64_t pk = obj.primary_key();
+      check(d.rows.find(pk) == d.rows.end(),
+            "could not insert object, most likely a uniqueness constraint was violated");
+      int64_t ram = billable_size(obj);
+      if (d.rows.empty()) ram += native::table_overhead_bytes;
+      auto it = d.rows.emplace(pk, std::move(obj)).first;
+      index_insert(d, it->second, std::index_sequence_for<Indices...>{});
+      count_emplace(ram);
+      return const_iterator(&d.rows, it);
+   }
+
+   template <typename Lambda>
+   void modify(const_iterator itr, name payer, Lambda&& updater) {
+      check(itr != end(), "cannot pass end iterator to modify");
+      modify(*itr, payer, std::forward<Lambda>(updater));
+   }
+
+   template <typename Lambda>
+   void modify(const T& obj, name, Lambda&& updater) {
+      auto& d = data();
+      auto it = d.rows.find(obj.primary_key());
+      check(it != d.rows.end(), "object passed to modify is not in multi_index");
+      uint64_t pk = it->second.primary_key();
+      int64_t before = billable_size(it->second);
+      auto old_keys = index_keys(it->second, std::index_sequence_for<Indices...>{});
+      updater(it->second);
+      check(pk == it->second.primary_key(), "updater cannot change primary key when modifying an object");
+      index_update(d, old_keys, it->second, std::index_sequence_for<Indices...>{});
+      count_write(billable_size(it->second) - before);
+   }
+
+   const_iterator erase(const_iterator itr) {
+      check(itr != end(), "cannot pass end iterator to erase");
+      auto next = itr;
+      ++next;
+      erase(*itr);
+      return next;
+   }
+
+   void erase(const T& obj) {
+      auto& d = data();
+      auto it = d.rows.find(obj.primary_key());
+      check(it != d.rows.end(), "object passed to erase is not in multi_index");
+      int64_t ram = -billable_size(it->second);
+      index_remove(d, it->second, std::index_sequence_for<Indices...>{});
+      d.rows.erase(it);
+      if (d.rows.empty()) ram -= native::table_overhead_bytes;
+      count_write(ram);
+   }
+
+private:
+   template <name::raw IndexName, size_t Pos>
+   static constexpr size_t index_position() { return Pos; }
+
+   template <name::raw IndexName, size_t Pos, typename First, typename... Rest>
+   static constexpr size_t index_position() {
+      if constexpr (First::index_name == name(IndexName)) return Pos;
+      else return index_position<IndexName, Pos + 1, Rest...>();
+   }
+
+   name _code;
+   uint64_t _scope;
+};
+
+} // namespace eosio
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+namespace eosio {
+
+/**
+ * Native stand-in for eosio::name (base32 account / table names)
+ */
+struct name {
+   enum class raw : uint64_t {};
+
+   uint64_t value = 0;
+
+   constexpr name() = default;
+   constexpr explicit name(uint64_t v) : value(v) {}
+   constexpr name(raw r) : value(static_cast<uint64_t>(r)) {}
+   constexpr explicit name(std::string_view str) : value(encode(str)) {}
+
+   static constexpr uint64_t char_to_value(char c) {
+      if (c == '.') return 0;
+      if (c >= '1' && c <= '5') return (c - '1') + 1;
+      if (c >= 'a' && c <= 'z') return (c - 'a') + 6;
+      return 0;
+   }
+
+   static constexpr uint64_t encode(std::string_view str) {
+      uint64_t v = 0;
+      int i = 0;
+      for (; i < static_cast<int>(str.size()) && i < 12; ++i) {
+         v <<= 5;
+         v |= char_to_value(str[i]);
+      }
+      v <<= (4 + 5 * (12 - i));
+      if (str.size() == 13) {
+         v |= char_to_value(str[12]) & 0x0F;
+      }
+      return v;
+   }
+
+   std::string to_string() const {
+      static const char* charmap = ".12345abcdefghijklmnopqrstuvwxyz";
+      std::string str(13, '.');
+      uint64_t tmp = value;
+      for (uint32_t i = 0; i <= 12; ++i) {
+         char c = charmap[tmp & (i == 0 ? 0x0f : 0x1f)];
+         str[12 - i] = c;
+         tmp >>= (i == 0 ? 4 : 5);
+      }
+      while (!str.empty() && str.back() == '.') str.pop_back();
+      return str;
+   }
+
+   constexpr operator raw() const { return static_cast<raw>(value); }
+   constexpr explicit operator bool() const { return value != 0; }
+
+   friend constexpr bool operator==(const name& a, const name& b) { return a.value == b.value; }
+   friend constexpr bool operator!=(const name& a, const name& b) { return a.value != b.value; }
+   friend constexpr bool operator<(const name& a, const name& b) { return a.value < b.value; }
+};
+
+inline constexpr name operator""_n(const char* s, std::size_t n) {
+   return name(std::string_view(s, n));
+}
+
+} // namespace eosio
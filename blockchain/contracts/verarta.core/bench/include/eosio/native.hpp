@@ -0,0 +1,86 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <set>
+#include <vector>
+
+#include "name.hpp"
+#include "time.hpp"
+
+// CDT provides these as builtin typedefs for the WASM target
+typedef unsigned __int128 uint128_t;
+typedef __int128 int128_t;
+
+namespace eosio { namespace native {
+
+/**
+ * RAM billing constants from the chain (config.hpp billable sizes)
+ */
+constexpr int64_t row_overhead_bytes = 108;           // key_value_object
+constexpr int64_t index64_overhead_bytes = 128;       // index64_object
+constexpr int64_t index128_overhead_bytes = 136;      // index128_object
+constexpr int64_t table_overhead_bytes = 108;         // table_id_object
+
+/**
+ * Rows one table gained and the RAM they were billed, table overhead included
+ */
+struct table_emplaces {
+   uint64_t rows = 0;
+   int64_t ram = 0;
+};
+
+/**
+ * Per-action resource counters collected by the in-memory tables
+ */
+struct usage {
+   uint64_t rows_read = 0;
+   uint64_t rows_written = 0;
+   int64_t ram_delta = 0;
+   std::map<name, table_emplaces> emplaces; // Keyed by table name
+};
+
+/**
+ * Process-wide stand-in for the chain context an action executes in
+ */
+struct chain_state {
+   std::set<uint64_t> auths;
+   uint32_t block_slot = 0;
+   uint32_t block_num = 1;
+   usage counters;
+   std::vector<std::function<void()>> resets;
+
+   static chain_state& get() {
+      static chain_state s;
+      return s;
+   }
+
+   void set_auth(std::initializer_list<name> accounts) {
+      auths.clear();
+      for (auto a : accounts) auths.insert(a.value);
+   }
+
+   void set_time(uint32_t sec_since_epoch) {
+      block_slot = uint32_t((int64_t(sec_since_epoch) * 1000 - block_timestamp::block_timestamp_epoch) /
+                            block_timestamp::block_interval_ms);
+   }
+
+   void advance_blocks(uint32_t n) {
+      block_slot += n;
+      block_num += n;
+   }
+
+   usage take_counters() {
+      usage u = counters;
+      counters = usage{};
+      return u;
+   }
+
+   /** Drop every table row; used between benchmark runs */
+   void reset_tables() {
+      for (auto& r : resets) r();
+   }
+};
+
+} } // namespace eosio::native
@@ -0,0 +1,34 @@
+#pragma once
+
+#include "check.hpp"
+#include "name.hpp"
+#include "native.hpp"
+#include "time.hpp"
+
+namespace eosio {
+
+inline bool has_auth(name n) {
+   return native::chain_state::get().auths.count(n.value) > 0;
+}
+
+inline void require_auth(name n) {
+   check(has_auth(n), "missing authority of " + n.to_string());
+}
+
+inline block_timestamp current_block_time() {
+   return block_timestamp(native::chain_state::get().block_slot);
+}
+
+inline time_point current_time_point() {
+   return current_block_time().to_time_point();
+}
+
+inline uint32_t current_block_number() {
+   return native::chain_state::get().block_num;
+}
+
+inline bool is_account(name) {
+   return true;
+}
+
+} // namespace eosio
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <cstdint>
+
+namespace eosio {
+
+class microseconds {
+public:
+   constexpr explicit microseconds(int64_t c = 0) : _count(c) {}
+   constexpr int64_t count() const { return _count; }
+private:
+   int64_t _count;
+};
+
+class time_point {
+public:
+   constexpr explicit time_point(microseconds e = microseconds()) : elapsed(e) {}
+   constexpr const microseconds& time_since_epoch() const { return elapsed; }
+   constexpr uint32_t sec_since_epoch() const { return uint32_t(elapsed.count() / 1000000); }
+private:
+   microseconds elapsed;
+};
+
+class time_point_sec {
+public:
+   constexpr time_point_sec() : utc_seconds(0) {}
+   constexpr explicit time_point_sec(uint32_t seconds) : utc_seconds(seconds) {}
+   constexpr uint32_t sec_since_epoch() const { return utc_seconds; }
+private:
+   uint32_t utc_seconds;
+};
+
+/**
+ * Half-second slot timestamp, as returned by current_block_time()
+ */
+class block_timestamp {
+public:
+   static constexpr int32_t block_interval_ms = 500;
+   static constexpr int64_t block_timestamp_epoch = 946684800000ll; // 2000-01-01
+
+   uint32_t slot = 0;
+
+   constexpr block_timestamp() = default;
+   constexpr explicit block_timestamp(uint32_t s) : slot(s) {}
+   explicit block_timestamp(const time_point& t) {
+      int64_t micro = t.time_since_epoch().count();
+      int64_t msec = micro / 1000;
+      slot = uint32_t((msec - block_timestamp_epoch) / int64_t(block_interval_ms));
+   }
+
+   time_point to_time_point() const {
+      int64_t msec = slot * int64_t(block_interval_ms) + block_timestamp_epoch;
+      return time_point(microseconds(msec * 1000));
+   }
+};
+
+} // namespace eosio
@@ -5,7 +5,7 @@ namespace verarta {
 
 // ========== ACTION IMPLEMENTATIONS ==========
 
-void verartatoken::createart(
+uint64_t verartatoken::createart(
    uint64_t artwork_id,
    name owner,
    std::string title_encrypted,
@@ -16,15 +16,20 @@ void verartatoken::createart(
    require_auth(owner);
 
    // Validate inputs
-   check(artwork_id > 0, "artwork_id must be positive");
+   limitsconfig limits = load_limits();
    check(title_encrypted.size() > 0, "title_encrypted cannot be empty");
-   check(title_encrypted.size() <= 1024, "title_encrypted too long");
-   check(description_encrypted.size() <= 10240, "description_encrypted too long");
-   check(metadata_encrypted.size() <= 10240, "metadata_encrypted too long");
+   check(title_encrypted.size() <= limits.max_title_size, "title_encrypted too long");
+   check(description_encrypted.size() <= limits.max_text_size, "description_encrypted too long");
+   check(metadata_encrypted.size() <= limits.max_text_size, "metadata_encrypted too long");
    check(creator_public_key.size() == 44, "invalid X25519 public key length");
 
    artworks_table artworks(get_self(), get_self().value);
 
+   globalstate state = load_state();
+   artwork_id = take_id(state.next_artwork_id, artwork_id);
+   save_state(state);
+   check(artwork_id > 0, "artwork_id must be positive");
+
    // Check if artwork_id already exists
    auto existing = artworks.find(artwork_id);
    check(existing == artworks.end(), "artwork_id already exists");
@@ -39,10 +44,21 @@ void verartatoken::createart(
       row.creator_public_key = creator_public_key;
       row.created_at = eosio::current_block_time().to_time_point().sec_since_epoch();
       row.file_count = 0;
+      row.deleting.emplace(false);
+      row.total_bytes.emplace(0);
+      row.completed_files.emplace(0);
+      row.thumbnail_file_id.emplace(0);
    });
+
+   storagestats stats = load_stats();
+   stats.artworks++;
+   save_stats(stats);
+   change_usage(owner, 1, 0, 0, 0);
+
+   return artwork_id;
 }
 
-void verartatoken::addfile(
+uint64_t verartatoken::addfile(
    uint64_t file_id,
    uint64_t artwork_id,
    name owner,
@@ -54,24 +70,44 @@ void verartatoken::addfile(
    std::vector<std::string> admin_encrypted_deks,
    std::string iv,
    std::string auth_tag,
-   bool is_thumbnail
+   bool is_thumbnail,
+   binary_extension<uint8_t> storage_mode,
+   binary_extension<std::vector<char>> inline_data,
+   binary_extension<uint64_t> source_file_id
 ) {
    require_auth(owner);
 
    // Validate inputs
-   check(file_id > 0, "file_id must be positive");
+   limitsconfig limits = load_limits();
    check(artwork_id > 0, "artwork_id must be positive");
    check(filename_encrypted.size() > 0, "filename_encrypted cannot be empty");
-   check(filename_encrypted.size() <= 512, "filename_encrypted too long");
+   check(filename_encrypted.size() <= limits.max_filename_size, "filename_encrypted too long");
    check(mime_type.size() > 0 && mime_type.size() <= 128, "invalid mime_type");
    check(file_size > 0, "file_size must be positive");
-   check(file_size <= 104857600, "file_size exceeds 100MB limit");
+   check(file_size <= file_size_limit(limits, owner), "file_size exceeds the account's file size limit");
    check(encrypted_dek.size() > 0, "encrypted_dek cannot be empty");
    check(iv.size() > 0, "iv cannot be empty");
    check(auth_tag.size() > 0, "auth_tag cannot be empty");
+   check(storage_mode.value_or() <= STORAGE_MODE_TRACE, "invalid storage_mode");
+
+   // Small files (thumbnails) can carry their whole payload here and skip
+   // the uploadchunk/completefile round trips. An empty inline_data only
+   // holds the place of source_file_id.
+   bool inline_upload = inline_data.has_value() && !inline_data.value().empty();
+   uint64_t source_id = source_file_id.value_or();
+   check(!(inline_upload && source_id != 0), "inline_data and source_file_id cannot both be set");
+   if (inline_upload) {
+      check(file_size <= limits.max_inline_size, "inline_data too large");
+      check(inline_data.value().size() == file_size, "inline_data length must equal file_size");
+      check(storage_mode.value_or() == STORAGE_MODE_TABLE, "inline_data requires table storage_mode");
+   }
 
-   // Check quota before creating file
-   check_and_update_quota(owner, file_size);
+   // Check quota before creating file. A duplicate counts as a file but
+   // uploads nothing.
+   check_and_update_quota(owner, source_id != 0 ? 0 : file_size, limits);
+   if (inline_upload) {
+      take_ingest_tokens(owner, file_size);
+   }
 
    artworks_table artworks(get_self(), get_self().value);
    artfiles_table artfiles(get_self(), get_self().value);
@@ -80,16 +116,73 @@ void verartatoken::addfile(
    auto artwork_itr = artworks.find(artwork_id);
    check(artwork_itr != artworks.end(), "artwork not found");
    check(artwork_itr->owner == owner, "artwork owner mismatch");
+   check(!artwork_itr->deleting.value_or(), "artwork is being deleted");
+   require_no_transfer(artwork_id);
+
+   bool chosen_id = file_id != 0;
+   globalstate state = load_state();
+   file_id = take_id(state.next_file_id, file_id);
+   save_state(state);
+   check(file_id > 0, "file_id must be positive");
 
    // Check if file_id already exists
    auto existing = artfiles.find(file_id);
    check(existing == artfiles.end(), "file_id already exists");
 
+   // A deleted file's scope may live on as the chunks of its duplicates
+   if (chosen_id) {
+      filechunks_table chunks(get_self(), file_id);
+      chunkreceipts_table receipts(get_self(), file_id);
+      check(chunks.begin() == chunks.end() && receipts.begin() == receipts.end(),
+            "file_id still holds shared chunks");
+   }
+
    // Validate admin encrypted DEKs match active admin keys
-   auto active_admin_keys = get_active_admin_keys();
-   check(admin_encrypted_deks.size() == active_admin_keys.size(),
+   check(admin_encrypted_deks.size() == active_admin_key_count(),
          "admin_encrypted_deks count must match active admin keys");
 
+   // An inline payload becomes chunk 0, so readers and deletefile treat the
+   // file like any other one-chunk upload. A duplicate takes over the
+   // source's chunk bookkeeping and one more reference to its chunks.
+   std::vector<uint8_t> received;
+   merkleacc merkle{};
+   uint32_t stored_chunks = 0;
+   uint64_t chunk_file_id = 0;
+   uint32_t now = eosio::current_block_time().to_time_point().sec_since_epoch();
+   if (inline_upload) {
+      filechunks_table chunks(get_self(), file_id);
+      chunkupload chunk{0, std::move(inline_data.value()), uint32_t(file_size)};
+      merkle_append(merkle, store_chunk(chunks, owner, file_id, STORAGE_MODE_TABLE, chunk, limits.max_inline_size, &received));
+      stored_chunks = 1;
+   } else if (source_id != 0) {
+      const auto& source = artfiles.get(source_id, "source file not found");
+      check(source.owner == owner, "source file owner mismatch");
+      check(source.upload_complete && !source.deleting.value_or(), "source file is not complete");
+      check(tracks_chunk_bitmap(source), "source file predates chunk tracking");
+      check(source.file_hash == file_hash && source.file_size == file_size && source.iv == iv,
+            "source file payload does not match");
+      check(source.storage_mode.value_or() == storage_mode.value_or(), "storage_mode does not match source file");
+
+      received = *source.chunk_bitmap;
+      merkle = source.chunk_merkle.value_or();
+      stored_chunks = source.total_chunks;
+      chunk_file_id = chunk_scope(source);
+
+      chunkrefs_table refs(get_self(), get_self().value);
+      auto ref_itr = refs.find(chunk_file_id);
+      if (ref_itr == refs.end()) {
+         refs.emplace(owner, [&](auto& row) {
+            row.chunk_file_id = chunk_file_id;
+            row.refs = 2;
+         });
+      } else {
+         refs.modify(ref_itr, same_payer, [&](auto& row) {
+            row.refs++;
+         });
+      }
+   }
+   bool complete = stored_chunks > 0;
+
    // Create file record
    artfiles.emplace(owner, [&](auto& row) {
       row.file_id = file_id;
@@ -104,78 +197,187 @@ void verartatoken::addfile(
       row.iv = iv;
       row.auth_tag = auth_tag;
       row.is_thumbnail = is_thumbnail;
-      row.total_chunks = 0;
-      row.uploaded_chunks = 0;
-      row.upload_complete = false;
-      row.created_at = eosio::current_block_time().to_time_point().sec_since_epoch();
-      row.completed_at = 0;
+      row.total_chunks = stored_chunks;
+      row.uploaded_chunks = stored_chunks;
+      row.upload_complete = complete;
+      row.created_at = now;
+      row.completed_at = complete ? now : 0;
+      row.deleting.emplace(false);
+      row.chunk_bitmap.emplace(std::move(received));
+      row.chunk_merkle.emplace(merkle);
+      row.storage_mode.emplace(storage_mode.value_or());
+      if (chunk_file_id != 0) {
+         row.chunk_file_id.emplace(chunk_file_id);
+      }
    });
 
+   storagestats stats = load_stats();
+   stats.files++;
+   stats.file_bytes += file_size;
+   if (inline_upload) {
+      stats.chunks++;
+      stats.chunk_bytes += file_size;
+   }
+   save_stats(stats);
+   if (complete) {
+      change_usage(owner, 0, 1, file_size, 0);
+   } else {
+      change_usage(owner, 0, 1, 0, file_size);
+   }
+
    // Increment artwork file count
    artworks.modify(artwork_itr, owner, [&](auto& row) {
       row.file_count++;
+      if (row.total_bytes.has_value()) row.total_bytes.value() += file_size;
+      if (complete && row.completed_files.has_value()) {
+         row.completed_files.value()++;
+         if (is_thumbnail) row.thumbnail_file_id.value() = std::max(row.thumbnail_file_id.value(), file_id);
+      }
    });
+
+   return file_id;
 }
 
 void verartatoken::uploadchunk(
-   uint64_t chunk_id,
    uint64_t file_id,
    name owner,
    uint32_t chunk_index,
-   std::string chunk_data,
+   std::vector<char> chunk_data,
    uint32_t chunk_size
 ) {
    check(has_auth(owner) || has_auth(get_self()), "missing required authority");
 
-   // Validate inputs
-   check(chunk_id > 0, "chunk_id must be positive");
    check(file_id > 0, "file_id must be positive");
-   check(chunk_data.size() > 0, "chunk_data cannot be empty");
-   check(chunk_data.size() <= 350000, "chunk_data too large (max ~350KB base64)");
-   check(chunk_size > 0 && chunk_size <= 262144, "invalid chunk_size (max 256KB)");
 
    artfiles_table artfiles(get_self(), get_self().value);
-   artchunks_table artchunks(get_self(), get_self().value);
-
-   // Verify file exists and owner matches
-   auto file_itr = artfiles.find(file_id);
-   check(file_itr != artfiles.end(), "file not found");
-   check(file_itr->owner == owner, "file owner mismatch");
-   check(!file_itr->upload_complete, "file upload already complete");
-
-   // Check if chunk_id already exists
-   auto existing = artchunks.find(chunk_id);
-   check(existing == artchunks.end(), "chunk_id already exists");
+   filechunks_table chunks(get_self(), file_id);
 
-   // Check if chunk_index already uploaded for this file
-   auto by_file_index = artchunks.get_index<"byfileindex"_n>();
-   uint128_t file_index_key = (uint128_t{file_id} << 64) | chunk_index;
-   auto file_index_itr = by_file_index.find(file_index_key);
-   check(file_index_itr == by_file_index.end(), "chunk_index already uploaded for this file");
+   auto file_itr = require_uploadable_file(artfiles, file_id, owner);
+   take_ingest_tokens(owner, chunk_data.size());
 
    // Create chunk record — use get_self() as RAM payer so the service key
    // can sign without requiring the user to co-sign for RAM allocation.
    name ram_payer = has_auth(get_self()) ? get_self() : owner;
-   artchunks.emplace(ram_payer, [&](auto& row) {
-      row.chunk_id = chunk_id;
-      row.file_id = file_id;
-      row.owner = owner;
-      row.chunk_index = chunk_index;
-      row.chunk_data = chunk_data;
-      row.chunk_size = chunk_size;
-      row.uploaded_at = eosio::current_block_time().to_time_point().sec_since_epoch();
-   });
+   bool tracked = tracks_chunk_bitmap(*file_itr);
+   bool merkle_tracked = tracked && tracks_chunk_merkle(*file_itr);
+   fileuploads_table uploads(get_self(), get_self().value);
+   fileupload progress = load_upload_progress(uploads, *file_itr);
+   uint8_t storage_mode = file_itr->storage_mode.value_or();
+   chunkupload chunk{chunk_index, std::move(chunk_data), chunk_size};
+   uint32_t max_chunk_size = chunk_size_limit(load_limits(), owner);
+   checksum256 chunk_hash = store_chunk(chunks, ram_payer, file_id, storage_mode, chunk, max_chunk_size, tracked ? &progress.chunk_bitmap : nullptr);
+   if (merkle_tracked) {
+      fold_chunk_hashes(file_id, storage_mode, progress.chunk_bitmap, progress.chunk_merkle, {{chunk_index, chunk_hash}});
+   }
 
-   // Increment uploaded_chunks counter
-   artfiles.modify(file_itr, same_payer, [&](auto& row) {
-      row.uploaded_chunks++;
-   });
+   // Count the chunk and record the index in the progress row only; the
+   // artfile row and the stats singleton are updated once, by completefile
+   progress.uploaded_chunks++;
+   progress.pending_chunks++;
+   progress.pending_bytes += chunk_size;
+   save_upload_progress(uploads, progress, ram_payer);
+}
+
+void verartatoken::uploadchunks(
+   uint64_t file_id,
+   name owner,
+   std::vector<chunkupload> chunks
+) {
+   check(has_auth(owner) || has_auth(get_self()), "missing required authority");
+
+   check(file_id > 0, "file_id must be positive");
+   check(chunks.size() > 0, "chunks cannot be empty");
+
+   uint64_t batch_bytes = 0;
+   for (const auto& chunk : chunks) {
+      batch_bytes += chunk.chunk_data.size();
+   }
+   check(batch_bytes <= MAX_CHUNK_BATCH_BYTES, "chunk batch too large (max 480KB)");
+
+   artfiles_table artfiles(get_self(), get_self().value);
+   filechunks_table file_chunks(get_self(), file_id);
+
+   // File checks run once for the whole batch
+   auto file_itr = require_uploadable_file(artfiles, file_id, owner);
+   take_ingest_tokens(owner, batch_bytes);
+
+   name ram_payer = has_auth(get_self()) ? get_self() : owner;
+   bool tracked = tracks_chunk_bitmap(*file_itr);
+   bool merkle_tracked = tracked && tracks_chunk_merkle(*file_itr);
+   fileuploads_table uploads(get_self(), get_self().value);
+   fileupload progress = load_upload_progress(uploads, *file_itr);
+   uint8_t storage_mode = file_itr->storage_mode.value_or();
+   uint32_t max_chunk_size = chunk_size_limit(load_limits(), owner);
+   std::vector<std::pair<uint32_t, checksum256>> hashes;
+   hashes.reserve(chunks.size());
+   for (auto& chunk : chunks) {
+      hashes.emplace_back(chunk.chunk_index, store_chunk(file_chunks, ram_payer, file_id, storage_mode, chunk, max_chunk_size, tracked ? &progress.chunk_bitmap : nullptr));
+   }
+   if (merkle_tracked) {
+      fold_chunk_hashes(file_id, storage_mode, progress.chunk_bitmap, progress.chunk_merkle, hashes);
+   }
+
+   // Single progress row update for the whole batch
+   progress.uploaded_chunks += chunks.size();
+   progress.pending_chunks += chunks.size();
+   progress.pending_bytes += batch_bytes;
+   save_upload_progress(uploads, progress, ram_payer);
+}
+
+bool verartatoken::migchunks(
+   uint32_t max_rows
+) {
+   require_auth(get_self());
+
+   check(max_rows > 0, "max_rows must be positive");
+
+   artchunks_table artchunks(get_self(), get_self().value);
+   storagestats stats = load_stats();
+
+   // Every moved row is erased, so begin() is the resume cursor. The erase
+   // refunds whoever paid for the legacy row; the new row is billed to the
+   // contract, the only account signing here.
+   auto chunk_itr = artchunks.begin();
+   for (uint32_t moved = 0; chunk_itr != artchunks.end() && moved < max_rows; ++moved) {
+      filechunks_table chunks(get_self(), chunk_itr->file_id);
+
+      // Uploads check legacy rows before writing to filechunks, so an index
+      // can only be present already if a previous move was interrupted.
+      if (chunks.find(chunk_itr->chunk_index) == chunks.end()) {
+         std::vector<char> data = chunk_itr->format_version.value_or() == CHUNK_FORMAT_RAW
+            ? chunk_itr->chunk_bytes.value_or()
+            : decode_base64(chunk_itr->chunk_data);
+         checksum256 chunk_hash = eosio::sha256(data.data(), data.size());
+         chunks.emplace(get_self(), [&](auto& row) {
+            row.chunk_index = chunk_itr->chunk_index;
+            row.chunk_size = chunk_itr->chunk_size;
+            row.uploaded_at = chunk_itr->uploaded_at;
+            row.chunk_data = std::move(data);
+            row.chunk_hash.emplace(chunk_hash);
+         });
+         chunkmetas_table metas(get_self(), chunk_itr->file_id);
+         metas.emplace(get_self(), [&](auto& row) {
+            row.chunk_index = chunk_itr->chunk_index;
+            row.chunk_size = chunk_itr->chunk_size;
+            row.chunk_hash = chunk_hash;
+         });
+      } else {
+         decrease(stats.chunks, 1);
+         decrease(stats.chunk_bytes, chunk_itr->chunk_size);
+      }
+
+      chunk_itr = artchunks.erase(chunk_itr);
+   }
+
+   save_stats(stats);
+   return chunk_itr == artchunks.end();
 }
 
 void verartatoken::completefile(
    uint64_t file_id,
    name owner,
-   uint32_t total_chunks
+   uint32_t total_chunks,
+   checksum256 merkle_root
 ) {
    check(has_auth(owner) || has_auth(get_self()), "missing required authority");
 
@@ -190,16 +392,124 @@ void verartatoken::completefile(
    check(file_itr != artfiles.end(), "file not found");
    check(file_itr->owner == owner, "file owner mismatch");
    check(!file_itr->upload_complete, "file already marked complete");
+   check(!file_itr->deleting.value_or(), "file is being deleted");
+
+   // Files of an artwork that is being deleted are swept with it
+   artworks_table artworks(get_self(), get_self().value);
+   auto artwork_itr = artworks.find(file_itr->artwork_id);
+   check(artwork_itr != artworks.end(), "artwork not found");
+   check(!artwork_itr->deleting.value_or(), "artwork is being deleted");
+
+   // Verify all chunks uploaded: exactly indices 0..total_chunks-1 when the
+   // bitmap is tracked, otherwise (legacy in-flight files) by count only
+   fileuploads_table uploads(get_self(), get_self().value);
+   fileupload progress = load_upload_progress(uploads, *file_itr);
+   bool tracked = tracks_chunk_bitmap(*file_itr);
+   bool merkle_tracked = tracked && tracks_chunk_merkle(*file_itr);
+   check(progress.uploaded_chunks == total_chunks, "not all chunks uploaded");
+   if (tracked) {
+      check(bitmap_is_prefix(progress.chunk_bitmap, total_chunks),
+            "uploaded chunk indices do not match 0..total_chunks-1");
+   }
 
-   // Verify all chunks uploaded
-   check(file_itr->uploaded_chunks == total_chunks, "not all chunks uploaded");
+   // The bitmap check above means every chunk has been folded, so this is
+   // one bagging pass over at most log2(MAX_CHUNKS_PER_FILE) + 1 peaks
+   if (merkle_tracked) {
+      check(progress.chunk_merkle.leaf_count == total_chunks, "chunk hashes not fully accumulated");
+      check(merkle_bag(progress.chunk_merkle.peaks) == merkle_root, "merkle_root does not match uploaded chunks");
+   }
 
-   // Mark file as complete — use same_payer since we're not adding RAM.
-   artfiles.modify(file_itr, same_payer, [&](auto& row) {
+   // Mark file as complete and take over the progress row. The bitmap and
+   // accumulator grow the row, so it is billed like the chunks were.
+   name ram_payer = has_auth(get_self()) ? get_self() : owner;
+   artfiles.modify(file_itr, ram_payer, [&](auto& row) {
       row.total_chunks = total_chunks;
+      row.uploaded_chunks = progress.uploaded_chunks;
       row.upload_complete = true;
       row.completed_at = eosio::current_block_time().to_time_point().sec_since_epoch();
+      if (tracked) set_upload_progress(row, std::move(progress.chunk_bitmap), merkle_tracked ? &progress.chunk_merkle : nullptr);
    });
+
+   storagestats stats = load_stats();
+   drop_upload_progress(*file_itr, stats);
+   save_stats(stats);
+
+   if (artwork_itr->completed_files.has_value()) {
+      artworks.modify(artwork_itr, same_payer, [&](auto& row) {
+         row.completed_files.value()++;
+         if (file_itr->is_thumbnail) row.thumbnail_file_id.value() = std::max(row.thumbnail_file_id.value(), file_id);
+      });
+   }
+
+   int64_t file_size = file_itr->file_size;
+   change_usage(owner, 0, 0, file_size, -file_size);
+}
+
+verartatoken::filemanifest verartatoken::getmanifest(uint64_t file_id, name reader, uint32_t start_index) {
+   artfiles_table artfiles(get_self(), get_self().value);
+   const auto& file = artfiles.get(file_id, "file not found");
+   check(file.upload_complete, "file upload not complete");
+   check(!file.deleting.value_or(), "file is being deleted");
+   check(start_index <= file.total_chunks, "start_index out of range");
+
+   filemanifest manifest{};
+   manifest.file_id = file.file_id;
+   manifest.artwork_id = file.artwork_id;
+   manifest.owner = file.owner;
+   manifest.filename_encrypted = file.filename_encrypted;
+   manifest.mime_type = file.mime_type;
+   manifest.file_size = file.file_size;
+   manifest.file_hash = file.file_hash;
+   manifest.is_thumbnail = file.is_thumbnail;
+   manifest.iv = file.iv;
+   manifest.storage_mode = file.storage_mode.value_or();
+   manifest.chunk_scope = chunk_scope(file);
+   manifest.total_chunks = file.total_chunks;
+
+   // Admin DEK positions shift as keys rotate, so an admin gets every
+   // candidate and tries its private key on each
+   if (reader == file.owner) {
+      manifest.encrypted_dek = file.encrypted_dek;
+      manifest.auth_tag = file.auth_tag;
+   } else if (reader != name() && has_active_admin_key(reader)) {
+      manifest.admin_encrypted_deks = file.admin_encrypted_deks;
+   }
+
+   uint32_t end_index = std::min(file.total_chunks, start_index + MAX_MANIFEST_CHUNKS);
+   manifest.chunks.reserve(end_index - start_index);
+   for (uint32_t index = start_index; index < end_index; index++) {
+      manifest.chunks.push_back(manifest_chunk(manifest.chunk_scope, manifest.storage_mode, file_id, index));
+   }
+   manifest.next_chunk_index = end_index;
+   return manifest;
+}
+
+verartatoken::chunkrange verartatoken::readchunks(uint64_t file_id, uint32_t start_index, uint32_t max_bytes) {
+   artfiles_table artfiles(get_self(), get_self().value);
+   const auto& file = artfiles.get(file_id, "file not found");
+   check(file.upload_complete, "file upload not complete");
+   check(!file.deleting.value_or(), "file is being deleted");
+   check(file.storage_mode.value_or() == STORAGE_MODE_TABLE, "trace-only file data is not held in tables");
+   check(start_index < file.total_chunks, "start_index out of range");
+   check(max_bytes > 0, "max_bytes must be positive");
+
+   uint64_t budget = std::min(max_bytes, MAX_READ_BYTES);
+   uint64_t scope = chunk_scope(file);
+
+   // The first chunk goes out whatever its size, so every call makes progress
+   chunkrange range{};
+   uint32_t index = start_index;
+   uint64_t used = append_chunk_data(range.data, scope, file_id, index++, ~uint64_t(0));
+   while (index < file.total_chunks && used < budget) {
+      uint32_t appended = append_chunk_data(range.data, scope, file_id, index, budget - used);
+      if (appended == 0) {
+         break;
+      }
+      used += appended;
+      index++;
+   }
+   range.next_chunk_index = index;
+   return range;
 }
 
 void verartatoken::setquota(
@@ -208,7 +518,9 @@ void verartatoken::setquota(
    uint32_t daily_file_limit,
    uint64_t daily_size_limit,
    uint32_t weekly_file_limit,
-   uint64_t weekly_size_limit
+   uint64_t weekly_size_limit,
+   binary_extension<uint64_t> ingest_rate,
+   binary_extension<uint64_t> ingest_burst
 ) {
    // Only contract account can set quotas
    require_auth(get_self());
@@ -221,6 +533,12 @@ void verartatoken::setquota(
    check(weekly_size_limit > 0, "weekly_size_limit must be positive");
    check(weekly_file_limit >= daily_file_limit, "weekly_file_limit must be >= daily_file_limit");
    check(weekly_size_limit >= daily_size_limit, "weekly_size_limit must be >= daily_size_limit");
+   if (ingest_rate.has_value()) {
+      check(ingest_rate.value() > 0, "ingest_rate must be positive");
+   }
+   if (ingest_burst.has_value()) {
+      check(ingest_burst.value() >= MAX_CHUNK_BATCH_BYTES, "ingest_burst must hold one chunk batch (480KB)");
+   }
 
    usagequotas_table quotas(get_self(), get_self().value);
    auto quota_itr = quotas.find(account.value);
@@ -228,6 +546,22 @@ void verartatoken::setquota(
    uint64_t current_time = eosio::current_block_time().to_time_point().sec_since_epoch();
    uint64_t daily_reset = (current_time / 86400) * 86400 + 86400; // Next midnight UTC
    uint64_t weekly_reset = calculate_next_monday(current_time);
+   uint64_t now_ms = eosio::current_block_time().to_time_point().time_since_epoch().count() / 1000;
+
+   // Settle the bucket at its old rate, then apply the new one. A new bucket
+   // starts full; tokens above a lowered burst are dropped.
+   auto set_ingest = [&](usagequota& row) {
+      bool fresh = !row.ingest_tokens.has_value();
+      refill_ingest_bucket(row, now_ms);
+      if (ingest_rate.has_value()) {
+         row.ingest_rate.value() = ingest_rate.value();
+      }
+      if (ingest_burst.has_value()) {
+         row.ingest_burst.value() = ingest_burst.value();
+      }
+      uint64_t burst = row.ingest_burst.value();
+      row.ingest_tokens.value() = fresh ? burst : std::min(row.ingest_tokens.value(), burst);
+   };
 
    if (quota_itr == quotas.end()) {
       // Create new quota
@@ -244,6 +578,7 @@ void verartatoken::setquota(
          row.weekly_files_used = 0;
          row.weekly_size_used = 0;
          row.weekly_reset_at = weekly_reset;
+         set_ingest(row);
       });
    } else {
       // Update existing quota (preserve usage counters)
@@ -253,11 +588,12 @@ void verartatoken::setquota(
          row.daily_size_limit = daily_size_limit;
          row.weekly_file_limit = weekly_file_limit;
          row.weekly_size_limit = weekly_size_limit;
+         set_ingest(row);
       });
    }
 }
 
-void verartatoken::addadminkey(
+uint64_t verartatoken::addadminkey(
    name admin_account,
    std::string public_key,
    std::string description
@@ -271,20 +607,19 @@ void verartatoken::addadminkey(
 
    adminkeys_table adminkeys(get_self(), get_self().value);
 
-   // Find next key_id
-   uint64_t key_id = 1;
-   auto idx = adminkeys.get_index<"byadmin"_n>();
-   for (auto itr = idx.begin(); itr != idx.end(); ++itr) {
-      if (itr->key_id >= key_id) {
-         key_id = itr->key_id + 1;
-      }
-   }
-
    // Check if this public_key already exists
    for (auto itr = adminkeys.begin(); itr != adminkeys.end(); ++itr) {
       check(itr->public_key != public_key, "public_key already exists");
    }
 
+   globalstate state = load_state();
+   uint64_t key_id = take_id(state.next_key_id, 0);
+   save_state(state);
+
+   // Load the key set before emplacing so a first-use build does not
+   // already include the new key.
+   adminkeyset keyset = load_admin_keyset();
+
    // Add admin key
    adminkeys.emplace(get_self(), [&](auto& row) {
       row.key_id = key_id;
@@ -294,6 +629,13 @@ void verartatoken::addadminkey(
       row.added_at = eosio::current_block_time().to_time_point().sec_since_epoch();
       row.is_active = true;
    });
+
+   // key_id is the largest ID allocated so far, so the list stays sorted
+   keyset.active_key_ids.push_back(key_id);
+   keyset.active_count = keyset.active_key_ids.size();
+   adminkeyset_singleton(get_self(), get_self().value).set(keyset, get_self());
+
+   return key_id;
 }
 
 void verartatoken::rmadminkey(uint64_t key_id) {
@@ -305,13 +647,23 @@ void verartatoken::rmadminkey(uint64_t key_id) {
 
    check(key_itr != adminkeys.end(), "admin key not found");
 
+   if (key_itr->is_active) {
+      adminkeyset keyset = load_admin_keyset();
+      auto pos = std::lower_bound(keyset.active_key_ids.begin(), keyset.active_key_ids.end(), key_id);
+      if (pos != keyset.active_key_ids.end() && *pos == key_id) {
+         keyset.active_key_ids.erase(pos);
+      }
+      keyset.active_count = keyset.active_key_ids.size();
+      adminkeyset_singleton(get_self(), get_self().value).set(keyset, get_self());
+   }
+
    // Mark as inactive (don't delete to preserve audit trail)
    adminkeys.modify(key_itr, get_self(), [&](auto& row) {
       row.is_active = false;
    });
 }
 
-void verartatoken::logaccess(
+uint64_t verartatoken::logaccess(
    name admin_account,
    uint64_t file_id,
    std::string reason
@@ -330,38 +682,108 @@ void verartatoken::logaccess(
    check(file_itr != artfiles.end(), "file not found");
 
    // Verify admin has an active admin key
-   adminkeys_table adminkeys(get_self(), get_self().value);
-   auto by_admin = adminkeys.get_index<"byadmin"_n>();
-   bool has_admin_key = false;
-   for (auto itr = by_admin.lower_bound(admin_account.value);
-        itr != by_admin.end() && itr->admin_account == admin_account;
-        ++itr) {
-      if (itr->is_active) {
-         has_admin_key = true;
-         break;
-      }
-   }
-   check(has_admin_key, "admin_account does not have an active admin key");
+   check(has_active_admin_key(admin_account), "admin_account does not have an active admin key");
 
-   // Find next log_id
-   uint64_t log_id = 1;
-   for (auto itr = logs.begin(); itr != logs.end(); ++itr) {
-      if (itr->log_id >= log_id) {
-         log_id = itr->log_id + 1;
-      }
-   }
+   globalstate state = load_state();
+   uint64_t log_id = take_id(state.next_log_id, 0);
+   save_state(state);
 
-   // Create log entry
-   logs.emplace(admin_account, [&](auto& row) {
+   auto fill = [&](auto& row) {
       row.log_id = log_id;
       row.admin_account = admin_account;
       row.file_id = file_id;
       row.reason = reason;
       row.accessed_at = eosio::current_block_time().to_time_point().sec_since_epoch();
-   });
+   };
+
+   auditconfig config = auditconfig_singleton(get_self(), get_self().value)
+      .get_or_default(auditconfig{false, DEFAULT_ACCESS_RING_SIZE});
+
+   storagestats stats = load_stats();
+   stats.access_logs++;
+
+   if (!config.trace_only) {
+      // Legacy mode: every entry kept in adminaccess
+      logs.emplace(admin_account, fill);
+      save_stats(stats);
+      return log_id;
+   }
+
+   // Trace-only mode: the action trace (indexed by Hyperion) is the audit
+   // record; RAM keeps only the most recent ring_size entries for this file.
+   accessring_table ring(get_self(), file_id);
+   ring.emplace(admin_account, fill);
+
+   uint32_t entries = 0;
+   for (auto itr = ring.begin(); itr != ring.end(); ++itr) {
+      entries++;
+   }
+   for (auto itr = ring.begin(); entries > config.ring_size; entries--) {
+      itr = ring.erase(itr);
+      decrease(stats.access_logs, 1);
+   }
+
+   save_stats(stats);
+   return log_id;
+}
+
+void verartatoken::setauditcfg(
+   bool trace_only,
+   uint32_t ring_size
+) {
+   require_auth(get_self());
+
+   check(ring_size > 0 && ring_size <= MAX_ACCESS_RING_SIZE, "ring_size must be between 1 and 100");
+
+   auditconfig_singleton config_table(get_self(), get_self().value);
+   config_table.set(auditconfig{trace_only, ring_size}, get_self());
+}
+
+void verartatoken::setlimits(limitsconfig limits) {
+   require_auth(get_self());
+
+   check(limits.max_file_size > 0 && limits.premium_max_file_size > 0, "file size limits must be positive");
+   check(limits.max_chunk_size > 0 && limits.max_chunk_size <= MAX_CHUNK_BATCH_BYTES &&
+         limits.premium_max_chunk_size > 0 && limits.premium_max_chunk_size <= MAX_CHUNK_BATCH_BYTES,
+         "chunk size limits must be between 1 and 480KB");
+   // Every allowed file must fit in the received-chunk bitmap
+   check(limits.max_file_size <= uint64_t(limits.max_chunk_size) * MAX_CHUNKS_PER_FILE &&
+         limits.premium_max_file_size <= uint64_t(limits.premium_max_chunk_size) * MAX_CHUNKS_PER_FILE,
+         "file size limit needs more than 8192 chunks");
+   check(limits.max_inline_size <= MAX_CHUNK_BATCH_BYTES, "max_inline_size must be at most 480KB");
+   check(limits.max_title_size > 0 && limits.max_text_size > 0 &&
+         limits.max_filename_size > 0 && limits.max_extras_size > 0,
+         "text size limits must be positive");
+   check(limits.default_daily_file_limit > 0 && limits.default_weekly_file_limit > 0,
+         "default file limits must be positive");
+
+   limits_singleton limits_table(get_self(), get_self().value);
+   limits_table.set(limits, get_self());
+}
+
+verartatoken::limitsconfig verartatoken::getlimits() {
+   return load_limits();
+}
+
+bool verartatoken::pruneaccess(uint32_t max_rows) {
+   require_auth(get_self());
+
+   check(max_rows > 0, "max_rows must be positive");
+
+   adminaccesslogs_table logs(get_self(), get_self().value);
+
+   storagestats stats = load_stats();
+   auto itr = logs.begin();
+   for (uint32_t erased = 0; itr != logs.end() && erased < max_rows; erased++) {
+      itr = logs.erase(itr);
+      decrease(stats.access_logs, 1);
+   }
+
+   save_stats(stats);
+   return itr == logs.end();
 }
 
-void verartatoken::deletefile(
+bool verartatoken::deletefile(
    uint64_t file_id,
    uint64_t artwork_id,
    name owner
@@ -373,34 +795,64 @@ void verartatoken::deletefile(
 
    artworks_table artworks(get_self(), get_self().value);
    artfiles_table artfiles(get_self(), get_self().value);
-   artchunks_table artchunks(get_self(), get_self().value);
 
    auto artwork_itr = artworks.find(artwork_id);
    check(artwork_itr != artworks.end(), "artwork not found");
-   check(artwork_itr->owner == owner, "artwork owner mismatch");
 
    auto file_itr = artfiles.find(file_id);
    check(file_itr != artfiles.end(), "file not found");
    check(file_itr->artwork_id == artwork_id, "file does not belong to artwork");
    check(file_itr->owner == owner, "file owner mismatch");
 
-   // Delete all chunks for this file
-   auto by_file = artchunks.get_index<"byfile"_n>();
-   auto chunk_itr = by_file.lower_bound(file_id);
-   while (chunk_itr != by_file.end() && chunk_itr->file_id == file_id) {
-      chunk_itr = by_file.erase(chunk_itr);
+   // A sweep that has started may finish during or after a transfer of the
+   // artwork: transfers pass over tombstoned files, which keep their owner
+   if (!file_itr->deleting.value_or()) {
+      check(artwork_itr->owner == owner, "artwork owner mismatch");
+      require_no_transfer(artwork_id);
    }
 
-   // Decrement artwork file count
+   uint32_t budget = MAX_DELETE_ROWS;
+
+   // Tombstone the file so uploads stop while chunks are being erased.
+   // Only the service key signs here, so the (slightly larger) row is
+   // billed to the contract until it is erased.
+   if (!file_itr->deleting.value_or()) {
+      artfiles.modify(file_itr, get_self(), [&](auto& row) {
+         row.deleting.emplace(true);
+      });
+   }
+
+   // Delete chunks for this file, up to the per-call budget
+   storagestats stats = load_stats();
+   if (!release_file_chunks(*file_itr, budget, stats) || budget == 0) {
+      save_stats(stats);
+      return false;
+   }
+
+   // Decrement artwork file count and aggregates
    artworks.modify(artwork_itr, same_payer, [&](auto& row) {
       if (row.file_count > 0) row.file_count--;
+      if (!row.total_bytes.has_value()) return;
+      decrease(row.total_bytes.value(), file_itr->file_size);
+      if (file_itr->upload_complete && row.completed_files.value() > 0) row.completed_files.value()--;
    });
+   if (artwork_itr->thumbnail_file_id.value_or() == file_id) {
+      uint64_t thumbnail_file_id = next_thumbnail(artwork_id, file_id);
+      artworks.modify(artwork_itr, same_payer, [&](auto& row) {
+         row.thumbnail_file_id.value() = thumbnail_file_id;
+      });
+   }
 
    // Delete the file record
+   decrease(stats.files, 1);
+   decrease(stats.file_bytes, file_itr->file_size);
+   release_file_usage(*file_itr);
    artfiles.erase(file_itr);
+   save_stats(stats);
+   return true;
 }
 
-void verartatoken::deleteart(
+bool verartatoken::deleteart(
    uint64_t artwork_id,
    name owner
 ) {
@@ -408,34 +860,67 @@ void verartatoken::deleteart(
 
    artworks_table artworks(get_self(), get_self().value);
    artfiles_table artfiles(get_self(), get_self().value);
-   artchunks_table artchunks(get_self(), get_self().value);
 
    // Verify artwork exists and owner matches
    auto artwork_itr = artworks.find(artwork_id);
    check(artwork_itr != artworks.end(), "artwork not found");
    check(artwork_itr->owner == owner, "artwork owner mismatch");
+   require_no_transfer(artwork_id);
+
+   // Tombstone the artwork on the first call; later calls resume the sweep
+   if (!artwork_itr->deleting.value_or()) {
+      artworks.modify(artwork_itr, owner, [&](auto& row) {
+         row.deleting.emplace(true);
+      });
+   }
 
-   // Delete all files and their chunks
+   uint32_t budget = MAX_DELETE_ROWS;
+   storagestats stats = load_stats();
+
+   // Delete files and their chunks. Every erased row leaves the index, so the
+   // lower_bound of each call is the resume cursor.
    auto by_artwork = artfiles.get_index<"byartwork"_n>();
    auto file_itr = by_artwork.lower_bound(artwork_id);
 
    while (file_itr != by_artwork.end() && file_itr->artwork_id == artwork_id) {
-      uint64_t file_id = file_itr->file_id;
+      if (budget == 0) {
+         save_stats(stats);
+         return false;
+      }
 
-      // Delete all chunks for this file
-      auto by_file = artchunks.get_index<"byfile"_n>();
-      auto chunk_itr = by_file.lower_bound(file_id);
+      // Tombstone the file so chunk uploads to it stop. The owner signed, so
+      // the row is billed to them (it may have been paid by a previous owner).
+      if (!file_itr->deleting.value_or()) {
+         by_artwork.modify(file_itr, owner, [&](auto& row) {
+            row.deleting.emplace(true);
+         });
+      }
 
-      while (chunk_itr != by_file.end() && chunk_itr->file_id == file_id) {
-         chunk_itr = by_file.erase(chunk_itr);
+      // Delete chunks for this file, up to the per-call budget
+      if (!release_file_chunks(*file_itr, budget, stats) || budget == 0) {
+         save_stats(stats);
+         return false;
       }
 
       // Delete file
+      decrease(stats.files, 1);
+      decrease(stats.file_bytes, file_itr->file_size);
+      release_file_usage(*file_itr);
       file_itr = by_artwork.erase(file_itr);
+      budget--;
+   }
+
+   if (budget == 0) {
+      save_stats(stats);
+      return false;
    }
 
    // Delete artwork
+   decrease(stats.artworks, 1);
+   change_usage(owner, -1, 0, 0, 0);
    artworks.erase(artwork_itr);
+   save_stats(stats);
+   return true;
 }
 
 void verartatoken::transferart(
@@ -460,13 +945,20 @@ void verartatoken::transferart(
    auto artwork_itr = artworks.find(artwork_id);
    check(artwork_itr != artworks.end(), "artwork not found");
    check(artwork_itr->owner == from, "artwork owner mismatch");
+   require_no_transfer(artwork_id);
+   check(!artwork_itr->deleting.value_or(), "artwork is being deleted");
 
    // Update each file's owner and re-encrypted DEK
+   int64_t complete_bytes = 0;
+   int64_t pending_bytes = 0;
    for (size_t i = 0; i < file_ids.size(); ++i) {
       auto file_itr = artfiles.find(file_ids[i]);
       check(file_itr != artfiles.end(), "file not found");
       check(file_itr->artwork_id == artwork_id, "file does not belong to artwork");
       check(file_itr->owner == from, "file owner mismatch");
+      check(!file_itr->deleting.value_or(), "file is being deleted");
+
+      (file_itr->upload_complete ? complete_bytes : pending_bytes) += file_itr->file_size;
 
       artfiles.modify(file_itr, same_payer, [&](auto& row) {
          row.owner = to;
@@ -476,9 +968,198 @@ void verartatoken::transferart(
    }
 
    // Transfer artwork ownership
-   artworks.modify(artwork_itr, same_payer, [&](auto& row) {
-      row.owner = to;
+   set_artwork_owner(artworks, artwork_itr, to);
+
+   int64_t files = file_ids.size();
+   change_usage(from, -1, -files, -complete_bytes, -pending_bytes);
+   change_usage(to, 1, files, complete_bytes, pending_bytes);
+}
+
+void verartatoken::syncart(uint64_t artwork_id) {
+   require_auth(get_self());
+
+   artworks_table artworks(get_self(), get_self().value);
+   auto artwork_itr = artworks.find(artwork_id);
+   check(artwork_itr != artworks.end(), "artwork not found");
+
+   // The extensions can grow the row, so the contract pays for it
+   artworks.modify(artwork_itr, get_self(), [&](auto& row) {
+      fill_artwork_aggregates(row);
+   });
+}
+
+bool verartatoken::reindex(uint32_t max_rows) {
+   require_auth(get_self());
+
+   check(max_rows > 0, "max_rows must be positive");
+
+   reindexstate_singleton state_table(get_self(), get_self().value);
+   reindexstate state = state_table.get_or_default(reindexstate{0, 0, false});
+   if (state.done) {
+      return true;
+   }
+
+   // Erasing and re-emplacing a row is the only way to give it entries in
+   // indexes added after it was written. The cursor is kept past each
+   // re-stored row, so rows are never visited twice.
+   uint32_t restored = 0;
+
+   artworks_table artworks(get_self(), get_self().value);
+   auto artwork_itr = artworks.lower_bound(state.next_artwork_id);
+   for (; artwork_itr != artworks.end() && restored < max_rows; restored++) {
+      artwork row = *artwork_itr;
+      state.next_artwork_id = row.artwork_id + 1;
+      artworks.erase(artwork_itr);
+      artworks.emplace(get_self(), [&](auto& r) { r = row; });
+      artwork_itr = artworks.lower_bound(state.next_artwork_id);
+   }
+
+   artfiles_table artfiles(get_self(), get_self().value);
+   auto file_itr = artfiles.lower_bound(state.next_file_id);
+   for (; file_itr != artfiles.end() && restored < max_rows; restored++) {
+      artfile row = *file_itr;
+      state.next_file_id = row.file_id + 1;
+      artfiles.erase(file_itr);
+      artfiles.emplace(get_self(), [&](auto& r) { r = row; });
+      file_itr = artfiles.lower_bound(state.next_file_id);
+   }
+
+   state.done = artwork_itr == artworks.end() && file_itr == artfiles.end();
+   state_table.set(state, get_self());
+   return state.done;
+}
+
+void verartatoken::xferbegin(
+   uint64_t artwork_id,
+   name from,
+   name to,
+   std::string memo
+) {
+   require_auth(from);
+
+   check(from != to, "cannot transfer to self");
+   check(is_account(to), "recipient account does not exist");
+
+   artworks_table artworks(get_self(), get_self().value);
+   auto artwork_itr = artworks.find(artwork_id);
+   check(artwork_itr != artworks.end(), "artwork not found");
+   check(artwork_itr->owner == from, "artwork owner mismatch");
+   check(!artwork_itr->deleting.value_or(), "artwork is being deleted");
+
+   pendingxfers_table transfers(get_self(), get_self().value);
+   check(transfers.find(artwork_id) == transfers.end(), "artwork transfer already in progress");
+
+   transfers.emplace(from, [&](auto& row) {
+      row.artwork_id = artwork_id;
+      row.from = from;
+      row.to = to;
+      row.last_file_id = 0;
+      row.files_done = 0;
+      row.complete_bytes = 0;
+      row.pending_bytes = 0;
+      row.started_at = eosio::current_block_time().to_time_point().sec_since_epoch();
+   });
+}
+
+bool verartatoken::xferbatch(
+   uint64_t artwork_id,
+   name from,
+   std::vector<filerekey> files
+) {
+   require_auth(from);
+
+   check(files.size() > 0, "files cannot be empty");
+   check(files.size() <= MAX_TRANSFER_BATCH, "too many files in batch (max 50)");
+
+   pendingxfers_table transfers(get_self(), get_self().value);
+   auto xfer_itr = transfers.find(artwork_id);
+   check(xfer_itr != transfers.end(), "no transfer in progress");
+   check(xfer_itr->from == from, "transfer owner mismatch");
+
+   artfiles_table artfiles(get_self(), get_self().value);
+   auto by_artwork = artfiles.get_index<"byartwork"_n>();
+   auto file_itr = next_transfer_file(artfiles, by_artwork, *xfer_itr);
+
+   pendingxfer progress = *xfer_itr;
+   int64_t complete_bytes = 0;
+   int64_t pending_bytes = 0;
+   for (const auto& rekey : files) {
+      check(file_itr != by_artwork.end() && file_itr->artwork_id == artwork_id, "all files already re-keyed");
+      check(file_itr->file_id == rekey.file_id, "file_id is not the next file of the artwork");
+
+      (file_itr->upload_complete ? complete_bytes : pending_bytes) += file_itr->file_size;
+      progress.files_done++;
+      progress.last_file_id = rekey.file_id;
+
+      // by_artwork key is unchanged, so the iterator stays valid
+      by_artwork.modify(file_itr, same_payer, [&](auto& row) {
+         row.owner = xfer_itr->to;
+         row.encrypted_dek = rekey.new_encrypted_dek;
+         row.auth_tag = rekey.new_auth_tag;
+      });
+      file_itr = skip_untransferable_files(by_artwork, ++file_itr, progress);
+   }
+
+   // Usage follows the files, so the recipient's completefile on a re-keyed
+   // file (and an xfercancel later on) leaves both accounts consistent
+   int64_t batch_files = files.size();
+   change_usage(from, 0, -batch_files, -complete_bytes, -pending_bytes);
+   change_usage(progress.to, 0, batch_files, complete_bytes, pending_bytes);
+
+   progress.complete_bytes += complete_bytes;
+   progress.pending_bytes += pending_bytes;
+   transfers.modify(xfer_itr, same_payer, [&](auto& row) {
+      row = progress;
    });
+
+   return file_itr == by_artwork.end() || file_itr->artwork_id != artwork_id;
+}
+
+void verartatoken::xferfinish(
+   uint64_t artwork_id,
+   name from
+) {
+   require_auth(from);
+
+   pendingxfers_table transfers(get_self(), get_self().value);
+   auto xfer_itr = transfers.find(artwork_id);
+   check(xfer_itr != transfers.end(), "no transfer in progress");
+   check(xfer_itr->from == from, "transfer owner mismatch");
+
+   // Every file is covered once the cursor is past the artwork's last file
+   artfiles_table artfiles(get_self(), get_self().value);
+   auto by_artwork = artfiles.get_index<"byartwork"_n>();
+   auto file_itr = next_transfer_file(artfiles, by_artwork, *xfer_itr);
+   check(file_itr == by_artwork.end() || file_itr->artwork_id != artwork_id, "not all files have been re-keyed");
+
+   artworks_table artworks(get_self(), get_self().value);
+   auto artwork_itr = artworks.find(artwork_id);
+   check(artwork_itr != artworks.end(), "artwork not found");
+
+   name to = xfer_itr->to;
+   set_artwork_owner(artworks, artwork_itr, to);
+
+   // File usage already moved with each batch
+   change_usage(from, -1, 0, 0, 0);
+   change_usage(to, 1, 0, 0, 0);
+
+   transfers.erase(xfer_itr);
+}
+
+void verartatoken::xfercancel(
+   uint64_t artwork_id,
+   name from
+) {
+   check(has_auth(from) || has_auth(get_self()), "missing required authority");
+
+   pendingxfers_table transfers(get_self(), get_self().value);
+   auto xfer_itr = transfers.find(artwork_id);
+   check(xfer_itr != transfers.end(), "no transfer in progress");
+   check(xfer_itr->from == from, "transfer owner mismatch");
+
+   // Re-keyed files carry the recipient's DEK and usage, so they stay with
+   // the recipient; a later transfer of the artwork passes over them
+   transfers.erase(xfer_itr);
 }
 
 void verartatoken::setextras(
@@ -491,15 +1172,29 @@ void verartatoken::setextras(
 
    check(artwork_id > 0, "artwork_id must be positive");
    check(extras_json.size() > 0, "extras_json cannot be empty");
-   check(extras_json.size() <= 20480, "extras_json too long (max 20KB)");
+   check(extras_json.size() <= load_limits().max_extras_size, "extras_json too long");
 
    artworks_table artworks(get_self(), get_self().value);
    auto artwork_itr = artworks.find(artwork_id);
    check(artwork_itr != artworks.end(), "artwork not found");
    check(artwork_itr->owner == owner, "artwork owner mismatch");
+   check(!artwork_itr->deleting.value_or(), "artwork is being deleted");
 
-   // No RAM writes — the action parameters are recorded in the action trace
-   // and indexed by Hyperion for later retrieval.
+   // The extras themselves stay in the action trace, indexed by Hyperion.
+   // The row records which call is current, so readers can fetch that one
+   // block, or confirm a cached copy by its hash, instead of scanning
+   // history. Fields before the pointer must be present, so artworks from
+   // before the aggregates existed get them computed here.
+   name ram_payer = has_auth(get_self()) ? get_self() : owner;
+   checksum256 extras_hash = eosio::sha256(extras_json.data(), extras_json.size());
+   artworks.modify(artwork_itr, ram_payer, [&](auto& row) {
+      if (!row.thumbnail_file_id.has_value()) {
+         fill_artwork_aggregates(row);
+      }
+      row.extras_version.emplace(row.extras_version.value_or() + 1);
+      row.extras_hash.emplace(extras_hash);
+      row.extras_block.emplace(eosio::current_block_number());
+   });
 }
 
 void verartatoken::addadmindek(uint64_t file_id, std::string new_encrypted_dek) {
@@ -512,8 +1207,7 @@ void verartatoken::addadmindek(uint64_t file_id, std::string new_encrypted_dek)
    auto it = artfiles.find(file_id);
    check(it != artfiles.end(), "file not found");
 
-   auto active_admin_keys = get_active_admin_keys();
-   check(it->admin_encrypted_deks.size() < active_admin_keys.size(),
+   check(it->admin_encrypted_deks.size() < active_admin_key_count(),
          "file already has DEKs for all active admin keys");
 
    artfiles.modify(it, get_self(), [&](auto& row) {
@@ -521,9 +1215,412 @@ void verartatoken::addadmindek(uint64_t file_id, std::string new_encrypted_dek)
    });
 }
 
-// ========== PRIVATE HELPER FUNCTIONS ==========
+void verartatoken::addadmindeks(std::vector<admindek> deks) {
+   require_auth(get_self()); // service key only
+
+   check(deks.size() > 0, "deks cannot be empty");
+   check(deks.size() <= MAX_ADMIN_DEK_BATCH, "too many DEKs in batch (max 100)");
+
+   // Key count is read once for the whole batch
+   uint32_t active_count = active_admin_key_count();
+   artfiles_table artfiles(get_self(), get_self().value);
+
+   for (auto& dek : deks) {
+      check(dek.file_id > 0, "file_id must be positive");
+      check(dek.new_encrypted_dek.size() > 0, "new_encrypted_dek cannot be empty");
+
+      auto it = artfiles.find(dek.file_id);
+      check(it != artfiles.end(), "file not found");
+      check(it->admin_encrypted_deks.size() < active_count,
+            "file already has DEKs for all active admin keys");
+
+      artfiles.modify(it, get_self(), [&](auto& row) {
+         row.admin_encrypted_deks.push_back(std::move(dek.new_encrypted_dek));
+      });
+   }
+}
+
+verartatoken::missingdekpage verartatoken::missingdeks(uint64_t lower_bound, uint32_t limit) {
+   check(limit > 0, "limit must be positive");
+
+   adminkeyset_singleton keyset_table(get_self(), get_self().value);
+   uint32_t active_count = keyset_table.exists() ? keyset_table.get().active_count : scan_admin_keys().active_count;
+   artfiles_table artfiles(get_self(), get_self().value);
+
+   missingdekpage page{{}, 0};
+   auto itr = artfiles.lower_bound(lower_bound);
+   for (uint32_t scanned = 0; itr != artfiles.end(); ++itr, ++scanned) {
+      if (scanned == MAX_MISSING_DEK_SCAN || page.file_ids.size() == limit) {
+         page.next_file_id = itr->file_id;
+         break;
+      }
+      if (itr->admin_encrypted_deks.size() < active_count) {
+         page.file_ids.push_back(itr->file_id);
+      }
+   }
+   return page;
+}
+
+verartatoken::storagestats verartatoken::getstats() {
+   return load_stats();
+}
+
+void verartatoken::setstats(storagestats stats) {
+   require_auth(get_self());
+   save_stats(stats);
+}
+
+verartatoken::ownerusage verartatoken::getusage(name owner) {
+   ownerusage_table usage(get_self(), get_self().value);
+   auto itr = usage.find(owner.value);
+   return itr != usage.end() ? *itr : ownerusage{owner, 0, 0, 0, 0};
+}
+
+void verartatoken::syncusage(name owner) {
+   require_auth(get_self());
+
+   ownerusage totals{owner, 0, 0, 0, 0};
+
+   artworks_table artworks(get_self(), get_self().value);
+   auto artworks_by_owner = artworks.get_index<"byowner"_n>();
+   for (auto itr = artworks_by_owner.lower_bound(owner.value);
+        itr != artworks_by_owner.end() && itr->owner == owner; ++itr) {
+      totals.artworks++;
+   }
+
+   artfiles_table artfiles(get_self(), get_self().value);
+   auto files_by_owner = artfiles.get_index<"byowner"_n>();
+   for (auto itr = files_by_owner.lower_bound(owner.value);
+        itr != files_by_owner.end() && itr->owner == owner; ++itr) {
+      totals.files++;
+      (itr->upload_complete ? totals.complete_bytes : totals.pending_bytes) += itr->file_size;
+   }
+
+   ownerusage_table usage(get_self(), get_self().value);
+   auto itr = usage.find(owner.value);
+   if (itr == usage.end()) {
+      usage.emplace(get_self(), [&](auto& row) { row = totals; });
+   } else {
+      usage.modify(itr, get_self(), [&](auto& row) { row = totals; });
+   }
+}
+
+// ========== PRIVATE HELPER FUNCTIONS ==========
+
+verartatoken::globalstate verartatoken::load_state() {
+   globalstate_singleton state_table(get_self(), get_self().value);
+   if (state_table.exists()) {
+      return state_table.get();
+   }
+
+   // First use after deploy: start every counter past the highest existing
+   // primary key (IDs start at 1).
+   artworks_table artworks(get_self(), get_self().value);
+   artfiles_table artfiles(get_self(), get_self().value);
+   adminkeys_table adminkeys(get_self(), get_self().value);
+   adminaccesslogs_table logs(get_self(), get_self().value);
+
+   globalstate state;
+   state.next_artwork_id = std::max<uint64_t>(artworks.available_primary_key(), 1);
+   state.next_file_id = std::max<uint64_t>(artfiles.available_primary_key(), 1);
+   state.next_key_id = std::max<uint64_t>(adminkeys.available_primary_key(), 1);
+   state.next_log_id = std::max<uint64_t>(logs.available_primary_key(), 1);
+   return state;
+}
+
+void verartatoken::save_state(const globalstate& state) {
+   globalstate_singleton state_table(get_self(), get_self().value);
+   state_table.set(state, get_self());
+}
+
+uint64_t verartatoken::take_id(uint64_t& counter, uint64_t requested) {
+   // The counter must never wrap: it would hand out 0 and then IDs that
+   // already exist, and every failed allocation rolls back its increment
+   if (requested == 0) {
+      check(counter < ~uint64_t(0), "ID space exhausted");
+      return counter++;
+   }
+   check(requested < ~uint64_t(0) - 1, "requested ID too large");
+
+   // Caller-chosen IDs are still accepted; keep the counter ahead of them so
+   // later allocations cannot collide.
+   if (requested >= counter) {
+      counter = requested + 1;
+   }
+   return requested;
+}
+
+verartatoken::storagestats verartatoken::load_stats() {
+   storagestats_singleton stats_table(get_self(), get_self().value);
+   return stats_table.get_or_default(storagestats{});
+}
+
+void verartatoken::save_stats(const storagestats& stats) {
+   storagestats_singleton stats_table(get_self(), get_self().value);
+   stats_table.set(stats, get_self());
+}
+
+void verartatoken::decrease(uint64_t& counter, uint64_t amount) {
+   counter = counter > amount ? counter - amount : 0;
+}
+
+void verartatoken::change_usage(
+   name owner,
+   int64_t artworks,
+   int64_t files,
+   int64_t complete_bytes,
+   int64_t pending_bytes
+) {
+   // Owners from before usage tracking have no row until syncusage runs, so
+   // decrements saturate at zero instead of failing
+   auto apply = [](uint64_t& counter, int64_t delta) {
+      if (delta >= 0) {
+         counter += delta;
+      } else {
+         decrease(counter, uint64_t(-delta));
+      }
+   };
+
+   ownerusage_table usage(get_self(), get_self().value);
+   auto itr = usage.find(owner.value);
+   if (itr == usage.end()) {
+      if (artworks <= 0 && files <= 0 && complete_bytes <= 0 && pending_bytes <= 0) {
+         return;
+      }
+      itr = usage.emplace(get_self(), [&](auto& row) {
+         row = ownerusage{owner, 0, 0, 0, 0};
+      });
+   }
+
+   ownerusage row = *itr;
+   apply(row.artworks, artworks);
+   apply(row.files, files);
+   apply(row.complete_bytes, complete_bytes);
+   apply(row.pending_bytes, pending_bytes);
+
+   // Reclaim the row once the owner holds nothing
+   if (row.artworks == 0 && row.files == 0 && row.complete_bytes == 0 && row.pending_bytes == 0) {
+      usage.erase(itr);
+      return;
+   }
+   usage.modify(itr, same_payer, [&](auto& r) { r = row; });
+}
 
-void verartatoken::check_and_update_quota(name account, uint64_t file_size) {
+verartatoken::artfiles_by_artwork::const_iterator verartatoken::next_transfer_file(
+   artfiles_table& artfiles,
+   const artfiles_by_artwork& by_artwork,
+   const pendingxfer& transfer
+) {
+   // Resume right after the last re-keyed file. Files cannot be added or
+   // erased while the artwork is locked, so the cursor row still exists.
+   if (transfer.last_file_id == 0) {
+      return skip_untransferable_files(by_artwork, by_artwork.lower_bound(transfer.artwork_id), transfer);
+   }
+   auto file_itr = by_artwork.iterator_to(artfiles.get(transfer.last_file_id, "transfer cursor file not found"));
+   return skip_untransferable_files(by_artwork, ++file_itr, transfer);
+}
+
+verartatoken::artfiles_by_artwork::const_iterator verartatoken::skip_untransferable_files(
+   const artfiles_by_artwork& by_artwork,
+   artfiles_by_artwork::const_iterator file_itr,
+   const pendingxfer& transfer
+) {
+   while (file_itr != by_artwork.end() && file_itr->artwork_id == transfer.artwork_id &&
+          (file_itr->owner != transfer.from || file_itr->deleting.value_or())) {
+      ++file_itr;
+   }
+   return file_itr;
+}
+
+void verartatoken::set_artwork_owner(
+   artworks_table& artworks,
+   artworks_table::const_iterator artwork_itr,
+   name to
+) {
+   bool indexed = reindex_done();
+
+   if (!indexed) {
+      auto by_owner_time = artworks.get_index<"byownertime"_n>();
+      uint128_t key = artwork_itr->by_owner_time();
+      for (auto itr = by_owner_time.lower_bound(key);
+           itr != by_owner_time.end() && itr->by_owner_time() == key; ++itr) {
+         if (itr->artwork_id == artwork_itr->artwork_id) {
+            indexed = true;
+            break;
+         }
+      }
+   }
+
+   if (indexed) {
+      artworks.modify(artwork_itr, same_payer, [&](auto& row) {
+         row.owner = to;
+      });
+      return;
+   }
+
+   artwork row = *artwork_itr;
+   row.owner = to;
+   artworks.erase(artwork_itr);
+   artworks.emplace(get_self(), [&](auto& r) { r = row; });
+}
+
+void verartatoken::fill_artwork_aggregates(artwork& row) {
+   uint32_t file_count = 0;
+   uint64_t total_bytes = 0;
+   uint32_t completed_files = 0;
+   uint64_t thumbnail_file_id = 0;
+
+   artfiles_table artfiles(get_self(), get_self().value);
+   auto by_artwork = artfiles.get_index<"byartwork"_n>();
+   for (auto itr = by_artwork.lower_bound(row.artwork_id);
+        itr != by_artwork.end() && itr->artwork_id == row.artwork_id; ++itr) {
+      file_count++;
+      total_bytes += itr->file_size;
+      if (itr->upload_complete) {
+         completed_files++;
+         if (itr->is_thumbnail && !itr->deleting.value_or()) thumbnail_file_id = std::max(thumbnail_file_id, itr->file_id);
+      }
+   }
+
+   row.file_count = file_count;
+   row.deleting.emplace(row.deleting.value_or());
+   row.total_bytes.emplace(total_bytes);
+   row.completed_files.emplace(completed_files);
+   row.thumbnail_file_id.emplace(thumbnail_file_id);
+}
+
+uint64_t verartatoken::next_thumbnail(uint64_t artwork_id, uint64_t excluded_file_id) {
+   uint64_t thumbnail_file_id = 0;
+   auto consider = [&](const artfile& file) {
+      if (file.is_thumbnail && file.upload_complete && !file.deleting.value_or() &&
+          file.file_id != excluded_file_id) {
+         thumbnail_file_id = std::max(thumbnail_file_id, file.file_id);
+      }
+   };
+
+   // Older rows are missing from bythumb until reindex is done, so walk the
+   // whole artwork in that case
+   artfiles_table artfiles(get_self(), get_self().value);
+   if (reindex_done()) {
+      auto by_thumb = artfiles.get_index<"bythumb"_n>();
+      uint128_t key = (uint128_t{artwork_id} << 64) | 1;
+      for (auto itr = by_thumb.lower_bound(key); itr != by_thumb.end() && itr->by_thumb() == key; ++itr) {
+         consider(*itr);
+      }
+   } else {
+      auto by_artwork = artfiles.get_index<"byartwork"_n>();
+      for (auto itr = by_artwork.lower_bound(artwork_id);
+           itr != by_artwork.end() && itr->artwork_id == artwork_id; ++itr) {
+         consider(*itr);
+      }
+   }
+   return thumbnail_file_id;
+}
+
+bool verartatoken::reindex_done() {
+   reindexstate_singleton state_table(get_self(), get_self().value);
+   return state_table.exists() && state_table.get().done;
+}
+
+void verartatoken::require_no_transfer(uint64_t artwork_id) {
+   pendingxfers_table transfers(get_self(), get_self().value);
+   check(transfers.find(artwork_id) == transfers.end(), "artwork transfer in progress");
+}
+
+void verartatoken::release_file_usage(const artfile& file) {
+   int64_t file_size = file.file_size;
+   if (file.upload_complete) {
+      change_usage(file.owner, 0, -1, -file_size, 0);
+   } else {
+      change_usage(file.owner, 0, -1, 0, -file_size);
+   }
+}
+
+verartatoken::artfiles_table::const_iterator verartatoken::require_uploadable_file(
+   artfiles_table& artfiles,
+   uint64_t file_id,
+   name owner
+) {
+   auto file_itr = artfiles.find(file_id);
+   check(file_itr != artfiles.end(), "file not found");
+   check(file_itr->owner == owner, "file owner mismatch");
+   check(!file_itr->upload_complete, "file upload already complete");
+   check(!file_itr->deleting.value_or(), "file is being deleted");
+
+   // deleteart tombstones only the artwork and sweeps its files in batches,
+   // so files it has not reached yet must stop taking chunks too
+   artworks_table artworks(get_self(), get_self().value);
+   auto artwork_itr = artworks.find(file_itr->artwork_id);
+   check(artwork_itr != artworks.end(), "artwork not found");
+   check(!artwork_itr->deleting.value_or(), "artwork is being deleted");
+   return file_itr;
+}
+
+checksum256 verartatoken::store_chunk(
+   filechunks_table& chunks,
+   name ram_payer,
+   uint64_t file_id,
+   uint8_t storage_mode,
+   chunkupload& chunk,
+   uint32_t max_chunk_size,
+   std::vector<uint8_t>* received
+) {
+   check(chunk.chunk_data.size() > 0, "chunk_data cannot be empty");
+   check(chunk.chunk_size > 0 && chunk.chunk_size <= max_chunk_size, "invalid chunk_size");
+   check(chunk.chunk_data.size() == chunk.chunk_size, "chunk_size does not match chunk_data length");
+
+   // Check if chunk_index already uploaded for this file
+   if (received) {
+      check(chunk.chunk_index < MAX_CHUNKS_PER_FILE, "chunk_index too large (max 8191)");
+      size_t byte = chunk.chunk_index / 8;
+      uint8_t bit = uint8_t(1) << (chunk.chunk_index % 8);
+      if (received->size() <= byte) {
+         received->resize(byte + 1, 0);
+      }
+      check(((*received)[byte] & bit) == 0, "chunk_index already uploaded for this file");
+      (*received)[byte] |= bit;
+   } else {
+      // Legacy file: earlier chunks may still sit in artchunks
+      artchunks_table artchunks(get_self(), get_self().value);
+      auto by_file_index = artchunks.get_index<"byfileindex"_n>();
+      uint128_t file_index_key = (uint128_t{file_id} << 64) | chunk.chunk_index;
+      check(by_file_index.find(file_index_key) == by_file_index.end(), "chunk_index already uploaded for this file");
+      check(chunks.find(chunk.chunk_index) == chunks.end(), "chunk_index already uploaded for this file");
+   }
+
+   checksum256 chunk_hash = eosio::sha256(chunk.chunk_data.data(), chunk.chunk_data.size());
+
+   // Trace-only files keep just enough to find and verify the data in the
+   // block that carries this action
+   if (storage_mode == STORAGE_MODE_TRACE) {
+      chunkreceipts_table receipts(get_self(), file_id);
+      receipts.emplace(ram_payer, [&](auto& row) {
+         row.chunk_index = chunk.chunk_index;
+         row.chunk_size = chunk.chunk_size;
+         row.chunk_hash = chunk_hash;
+         row.block_num = eosio::current_block_number();
+      });
+      return chunk_hash;
+   }
+
+   chunks.emplace(ram_payer, [&](auto& row) {
+      row.chunk_index = chunk.chunk_index;
+      row.chunk_size = chunk.chunk_size;
+      row.uploaded_at = eosio::current_block_time().to_time_point().sec_since_epoch();
+      row.chunk_data = std::move(chunk.chunk_data);
+      row.chunk_hash.emplace(chunk_hash);
+   });
+   chunkmetas_table metas(get_self(), file_id);
+   metas.emplace(ram_payer, [&](auto& row) {
+      row.chunk_index = chunk.chunk_index;
+      row.chunk_size = chunk.chunk_size;
+      row.chunk_hash = chunk_hash;
+   });
+
+   return chunk_hash;
+}
+
+void verartatoken::check_and_update_quota(name account, uint64_t file_size, const limitsconfig& limits) {
    usagequotas_table quotas(get_self(), get_self().value);
    auto quota_itr = quotas.find(account.value);
 
@@ -536,10 +1633,10 @@ void verartatoken::check_and_update_quota(name account, uint64_t file_size) {
       quotas.emplace(get_self(), [&](auto& row) {
          row.account = account;
          row.tier = 0; // Free tier
-         row.daily_file_limit = 10;
-         row.daily_size_limit = 26214400; // 25 MB
-         row.weekly_file_limit = 40;
-         row.weekly_size_limit = 104857600; // 100 MB
+         row.daily_file_limit = limits.default_daily_file_limit;
+         row.daily_size_limit = limits.default_daily_size_limit;
+         row.weekly_file_limit = limits.default_weekly_file_limit;
+         row.weekly_size_limit = limits.default_weekly_size_limit;
          row.daily_files_used = 1;
          row.daily_size_used = file_size;
          row.daily_reset_at = daily_reset;
@@ -591,6 +1688,121 @@ void verartatoken::check_and_update_quota(name account, uint64_t file_size) {
    });
 }
 
+verartatoken::limitsconfig verartatoken::load_limits() {
+   return limits_singleton(get_self(), get_self().value).get_or_default(default_limits());
+}
+
+verartatoken::limitsconfig verartatoken::default_limits() {
+   return limitsconfig{
+      DEFAULT_MAX_FILE_SIZE,
+      DEFAULT_MAX_FILE_SIZE,
+      DEFAULT_MAX_CHUNK_SIZE,
+      DEFAULT_MAX_CHUNK_SIZE,
+      DEFAULT_MAX_INLINE_SIZE,
+      DEFAULT_MAX_TITLE_SIZE,
+      DEFAULT_MAX_TEXT_SIZE,
+      DEFAULT_MAX_FILENAME_SIZE,
+      DEFAULT_MAX_EXTRAS_SIZE,
+      10,          // files per day
+      26214400,    // 25 MB per day
+      40,          // files per week
+      104857600,   // 100 MB per week
+   };
+}
+
+uint8_t verartatoken::account_tier(name account) {
+   usagequotas_table quotas(get_self(), get_self().value);
+   auto quota_itr = quotas.find(account.value);
+   return quota_itr == quotas.end() ? 0 : quota_itr->tier;
+}
+
+bool verartatoken::has_active_admin_key(name account) {
+   adminkeys_table adminkeys(get_self(), get_self().value);
+   auto by_admin = adminkeys.get_index<"byadmin"_n>();
+   for (auto itr = by_admin.lower_bound(account.value);
+        itr != by_admin.end() && itr->admin_account == account;
+        ++itr) {
+      if (itr->is_active) {
+         return true;
+      }
+   }
+   return false;
+}
+
+verartatoken::manifestchunk verartatoken::manifest_chunk(
+   uint64_t scope,
+   uint8_t storage_mode,
+   uint64_t file_id,
+   uint32_t chunk_index
+) {
+   if (storage_mode == STORAGE_MODE_TRACE) {
+      chunkreceipts_table receipts(get_self(), scope);
+      const auto& receipt = receipts.get(chunk_index, "chunk receipt not found");
+      return manifestchunk{chunk_index, receipt.chunk_size, receipt.chunk_hash, receipt.block_num};
+   }
+
+   chunkmetas_table metas(get_self(), scope);
+   auto itr = metas.find(chunk_index);
+   if (itr != metas.end()) {
+      return manifestchunk{chunk_index, itr->chunk_size, itr->chunk_hash, 0};
+   }
+
+   // Not yet moved by migchunks
+   artchunks_table artchunks(get_self(), get_self().value);
+   auto by_file_index = artchunks.get_index<"byfileindex"_n>();
+   auto legacy_itr = by_file_index.find((uint128_t{file_id} << 64) | chunk_index);
+   check(legacy_itr != by_file_index.end(), "chunk not found");
+   return manifestchunk{chunk_index, legacy_itr->chunk_size, checksum256(), 0};
+}
+
+uint32_t verartatoken::append_chunk_data(
+   std::vector<char>& out,
+   uint64_t scope,
+   uint64_t file_id,
+   uint32_t chunk_index,
+   uint64_t max_bytes
+) {
+   // One table object per chunk, so rows are not all held in memory while
+   // the page is assembled
+   filechunks_table chunks(get_self(), scope);
+   auto itr = chunks.find(chunk_index);
+   if (itr != chunks.end()) {
+      if (itr->chunk_data.size() > max_bytes) {
+         return 0;
+      }
+      out.insert(out.end(), itr->chunk_data.begin(), itr->chunk_data.end());
+      return itr->chunk_data.size();
+   }
+
+   // Not yet moved by migchunks
+   artchunks_table artchunks(get_self(), get_self().value);
+   auto by_file_index = artchunks.get_index<"byfileindex"_n>();
+   auto legacy_itr = by_file_index.find((uint128_t{file_id} << 64) | chunk_index);
+   check(legacy_itr != by_file_index.end(), "chunk not found");
+   if (legacy_itr->chunk_size > max_bytes) {
+      return 0;
+   }
+   std::vector<char> data = legacy_itr->format_version.value_or() == CHUNK_FORMAT_RAW
+      ? legacy_itr->chunk_bytes.value_or()
+      : decode_base64(legacy_itr->chunk_data);
+   out.insert(out.end(), data.begin(), data.end());
+   return data.size();
+}
+
+uint64_t verartatoken::file_size_limit(const limitsconfig& limits, name owner) {
+   if (limits.premium_max_file_size == limits.max_file_size) {
+      return limits.max_file_size;
+   }
+   return account_tier(owner) == 1 ? limits.premium_max_file_size : limits.max_file_size;
+}
+
+uint32_t verartatoken::chunk_size_limit(const limitsconfig& limits, name owner) {
+   if (limits.premium_max_chunk_size == limits.max_chunk_size) {
+      return limits.max_chunk_size;
+   }
+   return account_tier(owner) == 1 ? limits.premium_max_chunk_size : limits.max_chunk_size;
+}
+
 bool verartatoken::reset_quota_if_expired(usagequota& quota, uint64_t current_time) {
    bool reset_occurred = false;
 
@@ -613,17 +1825,348 @@ bool verartatoken::reset_quota_if_expired(usagequota& quota, uint64_t current_ti
    return reset_occurred;
 }
 
-std::vector<std::string> verartatoken::get_active_admin_keys() {
-   adminkeys_table adminkeys(get_self(), get_self().value);
-   std::vector<std::string> active_keys;
+void verartatoken::take_ingest_tokens(name account, uint64_t bytes) {
+   usagequotas_table quotas(get_self(), get_self().value);
+   auto quota_itr = quotas.find(account.value);
+
+   // addfile creates the quota row, so only files from before quotas
+   // existed get here without one; they are not throttled
+   if (quota_itr == quotas.end()) {
+      return;
+   }
+
+   uint64_t now_ms = eosio::current_block_time().to_time_point().time_since_epoch().count() / 1000;
+   quotas.modify(quota_itr, get_self(), [&](auto& row) {
+      refill_ingest_bucket(row, now_ms);
+      check(row.ingest_tokens.value() >= bytes, "chunk ingest rate exceeded, retry later");
+      row.ingest_tokens.value() -= bytes;
+   });
+}
+
+void verartatoken::refill_ingest_bucket(usagequota& quota, uint64_t now_ms) {
+   // Rows from before throttling start with a full bucket at the defaults.
+   // Extensions are set in order, since a later one cannot be serialized
+   // without the earlier ones.
+   if (!quota.ingest_rate.has_value()) {
+      quota.ingest_rate.emplace(DEFAULT_INGEST_RATE);
+   }
+   if (!quota.ingest_burst.has_value()) {
+      quota.ingest_burst.emplace(DEFAULT_INGEST_BURST);
+   }
+   if (!quota.ingest_tokens.has_value()) {
+      quota.ingest_tokens.emplace(quota.ingest_burst.value());
+   }
+   if (!quota.ingest_updated_ms.has_value()) {
+      quota.ingest_updated_ms.emplace(now_ms);
+   }
 
+   uint64_t burst = quota.ingest_burst.value();
+   uint64_t& tokens = quota.ingest_tokens.value();
+   uint64_t& updated_ms = quota.ingest_updated_ms.value();
+   if (now_ms > updated_ms && tokens < burst) {
+      uint128_t refill = uint128_t(now_ms - updated_ms) * quota.ingest_rate.value() / 1000;
+      tokens = refill >= burst - tokens ? burst : tokens + uint64_t(refill);
+   }
+   updated_ms = std::max(updated_ms, now_ms);
+}
+
+verartatoken::adminkeyset verartatoken::load_admin_keyset() {
+   adminkeyset_singleton keyset_table(get_self(), get_self().value);
+   if (keyset_table.exists()) {
+      return keyset_table.get();
+   }
+
+   // First use after deploy: one scan to build and store the set; afterwards
+   // addadminkey/rmadminkey keep it current.
+   adminkeyset keyset = scan_admin_keys();
+   keyset_table.set(keyset, get_self());
+   return keyset;
+}
+
+verartatoken::adminkeyset verartatoken::scan_admin_keys() {
+   adminkeys_table adminkeys(get_self(), get_self().value);
+   adminkeyset keyset{0, {}};
    for (auto itr = adminkeys.begin(); itr != adminkeys.end(); ++itr) {
       if (itr->is_active) {
-         active_keys.push_back(itr->public_key);
+         keyset.active_key_ids.push_back(itr->key_id);
+      }
+   }
+   keyset.active_count = keyset.active_key_ids.size();
+   return keyset;
+}
+
+uint32_t verartatoken::active_admin_key_count() {
+   return load_admin_keyset().active_count;
+}
+
+bool verartatoken::tracks_chunk_bitmap(const artfile& file) {
+   return file.chunk_bitmap.has_value() || file.uploaded_chunks == 0;
+}
+
+bool verartatoken::tracks_chunk_merkle(const artfile& file) {
+   return file.chunk_merkle.has_value() || file.uploaded_chunks == 0;
+}
+
+verartatoken::fileupload verartatoken::load_upload_progress(const fileuploads_table& uploads, const artfile& file) {
+   auto itr = uploads.find(file.file_id);
+   if (itr != uploads.end()) {
+      return *itr;
+   }
+
+   // Files that took chunks before fileuploads existed kept their progress
+   // in the file row; new files start from zero
+   return fileupload{
+      file.file_id,
+      file.uploaded_chunks,
+      file.chunk_bitmap.value_or(),
+      file.chunk_merkle.value_or(),
+      0,
+      0,
+   };
+}
+
+void verartatoken::save_upload_progress(fileuploads_table& uploads, const fileupload& progress, name ram_payer) {
+   auto itr = uploads.find(progress.file_id);
+   if (itr == uploads.end()) {
+      uploads.emplace(ram_payer, [&](auto& row) { row = progress; });
+   } else {
+      uploads.modify(itr, ram_payer, [&](auto& row) { row = progress; });
+   }
+}
+
+void verartatoken::drop_upload_progress(const artfile& file, storagestats& stats) {
+   fileuploads_table uploads(get_self(), get_self().value);
+   auto itr = uploads.find(file.file_id);
+   if (itr == uploads.end()) {
+      return;
+   }
+
+   if (file.storage_mode.value_or() == STORAGE_MODE_TRACE) {
+      stats.receipts += itr->pending_chunks;
+      stats.receipt_bytes += itr->pending_bytes;
+   } else {
+      stats.chunks += itr->pending_chunks;
+      stats.chunk_bytes += itr->pending_bytes;
+   }
+   uploads.erase(itr);
+}
+
+void verartatoken::set_upload_progress(artfile& row, std::vector<uint8_t>&& bitmap, const merkleacc* merkle) {
+   if (!row.deleting.has_value()) {
+      row.deleting.emplace(false);
+   }
+   row.chunk_bitmap.emplace(std::move(bitmap));
+   if (merkle) {
+      row.chunk_merkle.emplace(*merkle);
+   }
+}
+
+void verartatoken::fold_chunk_hashes(
+   uint64_t file_id,
+   uint8_t storage_mode,
+   const std::vector<uint8_t>& received,
+   merkleacc& merkle,
+   const std::vector<std::pair<uint32_t, checksum256>>& fresh
+) {
+   // Leaves are folded strictly in index order. In-order uploads fold their
+   // own hashes straight away; a chunk that arrives early waits until the
+   // gap before it is filled and is read back from its (small) receipt or
+   // chunkmetas row, so closing a gap never loads chunk data.
+   chunkmetas_table metas(get_self(), file_id);
+   while (bitmap_has(received, merkle.leaf_count)) {
+      auto fresh_itr = std::find_if(fresh.begin(), fresh.end(), [&](const auto& entry) {
+         return entry.first == merkle.leaf_count;
+      });
+
+      if (fresh_itr != fresh.end()) {
+         merkle_append(merkle, fresh_itr->second);
+      } else if (storage_mode == STORAGE_MODE_TRACE) {
+         chunkreceipts_table receipts(get_self(), file_id);
+         merkle_append(merkle, receipts.get(merkle.leaf_count, "received chunk not found").chunk_hash);
+      } else {
+         merkle_append(merkle, metas.get(merkle.leaf_count, "received chunk not found").chunk_hash);
+      }
+   }
+}
+
+void verartatoken::merkle_append(merkleacc& merkle, const checksum256& leaf) {
+   // Each trailing one bit of the leaf count is a perfect subtree of the
+   // same height as the new node; merge with them, then push the result
+   checksum256 node = leaf;
+   for (uint32_t count = merkle.leaf_count; count & 1; count >>= 1) {
+      node = hash_pair(merkle.peaks.back(), node);
+      merkle.peaks.pop_back();
+   }
+   merkle.peaks.push_back(node);
+   merkle.leaf_count++;
+}
+
+checksum256 verartatoken::merkle_bag(const std::vector<checksum256>& peaks) {
+   checksum256 root = peaks.back();
+   for (size_t i = peaks.size() - 1; i-- > 0; ) {
+      root = hash_pair(peaks[i], root);
+   }
+   return root;
+}
+
+checksum256 verartatoken::hash_pair(const checksum256& left, const checksum256& right) {
+   std::array<char, 64> buffer;
+   auto left_bytes = left.extract_as_byte_array();
+   auto right_bytes = right.extract_as_byte_array();
+   std::copy(left_bytes.begin(), left_bytes.end(), buffer.begin());
+   std::copy(right_bytes.begin(), right_bytes.end(), buffer.begin() + 32);
+   return eosio::sha256(buffer.data(), buffer.size());
+}
+
+bool verartatoken::bitmap_has(const std::vector<uint8_t>& bitmap, uint32_t index) {
+   size_t byte = index / 8;
+   return byte < bitmap.size() && (bitmap[byte] & (uint8_t(1) << (index % 8))) != 0;
+}
+
+bool verartatoken::bitmap_is_prefix(const std::vector<uint8_t>& bitmap, uint32_t count) {
+   size_t full_bytes = count / 8;
+   uint8_t tail_mask = uint8_t((1u << (count % 8)) - 1);
+   size_t used_bytes = full_bytes + (tail_mask ? 1 : 0);
+
+   if (bitmap.size() < used_bytes) {
+      return false;
+   }
+   for (size_t i = 0; i < full_bytes; i++) {
+      if (bitmap[i] != 0xFF) return false;
+   }
+   if (tail_mask && bitmap[full_bytes] != tail_mask) {
+      return false;
+   }
+   for (size_t i = used_bytes; i < bitmap.size(); i++) {
+      if (bitmap[i] != 0) return false;
+   }
+   return true;
+}
+
+bool verartatoken::erase_file_chunks(
+   uint64_t file_id,
+   uint32_t& budget,
+   storagestats& stats
+) {
+   // The file's own scopes first: plain primary-key sweeps
+   filechunks_table chunks(get_self(), file_id);
+   for (auto itr = chunks.begin(); itr != chunks.end(); ) {
+      if (budget == 0) {
+         return false;
+      }
+      decrease(stats.chunks, 1);
+      decrease(stats.chunk_bytes, itr->chunk_size);
+      itr = chunks.erase(itr);
+      budget--;
+   }
+
+   chunkreceipts_table receipts(get_self(), file_id);
+   for (auto itr = receipts.begin(); itr != receipts.end(); ) {
+      if (budget == 0) {
+         return false;
+      }
+      decrease(stats.receipts, 1);
+      decrease(stats.receipt_bytes, itr->chunk_size);
+      itr = receipts.erase(itr);
+      budget--;
+   }
+
+   // Their metadata rows (not counted in stats)
+   chunkmetas_table metas(get_self(), file_id);
+   for (auto itr = metas.begin(); itr != metas.end(); ) {
+      if (budget == 0) {
+         return false;
+      }
+      itr = metas.erase(itr);
+      budget--;
+   }
+
+   // Then any rows not yet moved out of the legacy table
+   artchunks_table artchunks(get_self(), get_self().value);
+   auto by_file = artchunks.get_index<"byfile"_n>();
+   auto chunk_itr = by_file.lower_bound(file_id);
+
+   while (chunk_itr != by_file.end() && chunk_itr->file_id == file_id) {
+      if (budget == 0) {
+         return false;
+      }
+      decrease(stats.chunks, 1);
+      decrease(stats.chunk_bytes, chunk_itr->chunk_size);
+      chunk_itr = by_file.erase(chunk_itr);
+      budget--;
+   }
+
+   return true;
+}
+
+uint64_t verartatoken::chunk_scope(const artfile& file) {
+   uint64_t shared = file.chunk_file_id.value_or();
+   return shared != 0 ? shared : file.file_id;
+}
+
+bool verartatoken::release_file_chunks(const artfile& file, uint32_t& budget, storagestats& stats) {
+   // Chunks of an unfinished upload are counted before they are erased
+   drop_upload_progress(file, stats);
+
+   // The access ring is the file's own, whether or not its chunks are shared
+   accessring_table ring(get_self(), file.file_id);
+   for (auto itr = ring.begin(); itr != ring.end(); ) {
+      if (budget == 0) {
+         return false;
+      }
+      decrease(stats.access_logs, 1);
+      itr = ring.erase(itr);
+      budget--;
+   }
+
+   uint64_t scope = chunk_scope(file);
+
+   // Other files still read these chunks: give up this file's reference
+   // only. The row goes when a single holder is left, which then erases.
+   chunkrefs_table refs(get_self(), get_self().value);
+   auto ref_itr = refs.find(scope);
+   if (ref_itr != refs.end()) {
+      if (ref_itr->refs > 2) {
+         refs.modify(ref_itr, same_payer, [&](auto& row) {
+            row.refs--;
+         });
+      } else {
+         refs.erase(ref_itr);
+      }
+      return true;
+   }
+
+   return erase_file_chunks(scope, budget, stats);
+}
+
+std::vector<char> verartatoken::decode_base64(const std::string& input) {
+   auto sextet = [](char c) -> int {
+      if (c >= 'A' && c <= 'Z') return c - 'A';
+      if (c >= 'a' && c <= 'z') return c - 'a' + 26;
+      if (c >= '0' && c <= '9') return c - '0' + 52;
+      if (c == '+') return 62;
+      if (c == '/') return 63;
+      return -1;
+   };
+
+   std::vector<char> output;
+   output.reserve(input.size() / 4 * 3);
+
+   uint32_t buffer = 0;
+   int bits = 0;
+   for (char c : input) {
+      if (c == '=') break;
+      int value = sextet(c);
+      check(value >= 0, "invalid base64 chunk_data");
+      buffer = (buffer << 6) | uint32_t(value);
+      bits += 6;
+      if (bits >= 8) {
+         bits -= 8;
+         output.push_back(char((buffer >> bits) & 0xFF));
       }
    }
 
-   return active_keys;
+   return output;
 }
 
 uint64_t verartatoken::calculate_next_monday(uint64_t from_time) {
@@ -652,4 +2195,4 @@ uint64_t verartatoken::calculate_next_monday(uint64_t from_time) {
 } // namespace verarta
 
 // Dispatch actions
-EOSIO_DISPATCH(verarta::verartatoken, (createart)(setextras)(addfile)(uploadchunk)(completefile)(setquota)(addadminkey)(rmadminkey)(addadmindek)(logaccess)(deleteart)(deletefile)(transferart))
+EOSIO_DISPATCH(verarta::verartatoken, (createart)(setextras)(addfile)(uploadchunk)(uploadchunks)(migchunks)(completefile)(getmanifest)(readchunks)(setquota)(addadminkey)(rmadminkey)(addadmindek)(addadmindeks)(missingdeks)(logaccess)(setauditcfg)(setlimits)(getlimits)(pruneaccess)(getstats)(setstats)(getusage)(syncusage)(deleteart)(deletefile)(transferart)(syncart)(reindex)(xferbegin)(xferbatch)(xferfinish)(xfercancel))
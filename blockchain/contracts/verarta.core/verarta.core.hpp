@@ -2,6 +2,8 @@
 
 #include <eosio/eosio.hpp>
 #include <eosio/asset.hpp>
+#include <eosio/binary_extension.hpp>
+#include <eosio/singleton.hpp>
 #include <eosio/crypto.hpp>
 #include <eosio/time.hpp>
 #include <eosio/system.hpp>
@@ -10,6 +12,42 @@ using namespace eosio;
 
 namespace verarta {
 
+// Chunk payload encodings (artchunk::format_version)
+static constexpr uint8_t CHUNK_FORMAT_BASE64 = 0;   // Legacy: base64 text in chunk_data
+static constexpr uint8_t CHUNK_FORMAT_RAW = 1;      // Raw ciphertext in chunk_bytes
+
+// File chunk storage modes (artfile::storage_mode)
+static constexpr uint8_t STORAGE_MODE_TABLE = 0;    // Chunk data kept in filechunks
+static constexpr uint8_t STORAGE_MODE_TRACE = 1;    // Only a chunkreceipts row; data lives in the action trace
+
+// Defaults for the limits singleton until setlimits stores one
+static constexpr uint64_t DEFAULT_MAX_FILE_SIZE = 104857600;   // 100MB per file
+static constexpr uint32_t DEFAULT_MAX_CHUNK_SIZE = 262144;     // 256KB per chunk
+static constexpr uint32_t DEFAULT_MAX_INLINE_SIZE = 65536;     // 64KB; larger files go through uploadchunk
+static constexpr uint32_t DEFAULT_MAX_TITLE_SIZE = 1024;       // title_encrypted
+static constexpr uint32_t DEFAULT_MAX_TEXT_SIZE = 10240;       // description_encrypted, metadata_encrypted
+static constexpr uint32_t DEFAULT_MAX_FILENAME_SIZE = 512;     // filename_encrypted
+static constexpr uint32_t DEFAULT_MAX_EXTRAS_SIZE = 20480;     // setextras extras_json
+
+static constexpr uint32_t MAX_CHUNK_BATCH_BYTES = 491520;   // 480KB per uploadchunks, under the 512KB action limit; caps every chunk size limit
+
+static constexpr uint64_t DEFAULT_INGEST_RATE = 1048576;    // Chunk bytes per second refilled into an account's bucket
+static constexpr uint64_t DEFAULT_INGEST_BURST = 4194304;   // Bucket capacity; must hold one full uploadchunks batch
+
+static constexpr uint32_t MAX_CHUNKS_PER_FILE = 8192;       // Caps the received-chunk bitmap at 1KB
+static constexpr uint32_t MAX_DELETE_ROWS = 100;           // Rows erased per deletefile/deleteart call
+
+static constexpr uint32_t MAX_TRANSFER_BATCH = 50;          // Files re-keyed per xferbatch call
+
+static constexpr uint32_t MAX_MANIFEST_CHUNKS = 256;        // Chunk entries per getmanifest call
+static constexpr uint32_t MAX_READ_BYTES = 1048576;         // Chunk data per readchunks call (1MB)
+
+static constexpr uint32_t MAX_ADMIN_DEK_BATCH = 100;        // Files per addadmindeks call
+static constexpr uint32_t MAX_MISSING_DEK_SCAN = 1000;      // artfiles rows examined per missingdeks call
+
+static constexpr uint32_t DEFAULT_ACCESS_RING_SIZE = 10;    // Recent access log rows kept per file
+static constexpr uint32_t MAX_ACCESS_RING_SIZE = 100;
+
 class [[eosio::contract("verarta.core")]] verartatoken : public contract {
 public:
    using contract::contract;
@@ -18,15 +56,16 @@ public:
 
    /**
     * Create artwork record
-    * @param artwork_id - Unique artwork ID
+    * @param artwork_id - Unique artwork ID, or 0 to allocate the next one
     * @param owner - Owner account
     * @param title_encrypted - Encrypted title (base64)
     * @param description_encrypted - Encrypted description (base64)
     * @param metadata_encrypted - Encrypted JSON metadata (base64)
     * @param creator_public_key - Creator's X25519 public key for encryption
+    * @return The artwork ID used
     */
    [[eosio::action]]
-   void createart(
+   uint64_t createart(
       uint64_t artwork_id,
       name owner,
       std::string title_encrypted,
@@ -37,7 +76,7 @@ public:
 
    /**
     * Add file to artwork with encrypted DEK
-    * @param file_id - Unique file ID
+    * @param file_id - Unique file ID, or 0 to allocate the next one
     * @param artwork_id - Parent artwork ID
     * @param owner - Owner account
     * @param filename_encrypted - Encrypted filename
@@ -49,9 +88,18 @@ public:
     * @param iv - Initialization vector for AES-GCM
     * @param auth_tag - Authentication tag for AES-GCM
     * @param is_thumbnail - Whether this is a thumbnail
+    * @param storage_mode - STORAGE_MODE_* for the file's chunks (optional, default table)
+    * @param inline_data - Whole encrypted payload for files up to max_inline_size
+    *                      (optional). Stored as chunk 0 and the file is created
+    *                      complete, so no uploadchunk/completefile follows.
+    * @param source_file_id - Completed file of the same owner whose chunks this
+    *                         file shares (optional). Needs the same file_hash,
+    *                         file_size and iv, i.e. the same ciphertext; the
+    *                         file is created complete without any upload.
+    * @return The file ID used
     */
    [[eosio::action]]
-   void addfile(
+   uint64_t addfile(
       uint64_t file_id,
       uint64_t artwork_id,
       name owner,
@@ -63,41 +111,145 @@ public:
       std::vector<std::string> admin_encrypted_deks,
       std::string iv,
       std::string auth_tag,
-      bool is_thumbnail
+      bool is_thumbnail,
+      binary_extension<uint8_t> storage_mode,
+      binary_extension<std::vector<char>> inline_data,
+      binary_extension<uint64_t> source_file_id
    );
 
    /**
-    * Upload file chunk
-    * @param chunk_id - Unique chunk ID
+    * Upload file chunk. Progress goes to the file's fileuploads row; the
+    * artfile row is only read.
     * @param file_id - Parent file ID
     * @param owner - Owner account
     * @param chunk_index - Zero-based chunk index
-    * @param chunk_data - Encrypted chunk data (base64)
-    * @param chunk_size - Size of this chunk in bytes
+    * @param chunk_data - Encrypted chunk data (raw bytes)
+    * @param chunk_size - Size of this chunk in bytes (must equal chunk_data length)
     */
    [[eosio::action]]
    void uploadchunk(
-      uint64_t chunk_id,
       uint64_t file_id,
       name owner,
       uint32_t chunk_index,
-      std::string chunk_data,
+      std::vector<char> chunk_data,
       uint32_t chunk_size
    );
 
    /**
-    * Mark file upload as complete
+    * One chunk of an uploadchunks batch
+    */
+   struct chunkupload {
+      uint32_t chunk_index;                  // Zero-based index
+      std::vector<char> chunk_data;          // Encrypted chunk data (raw bytes)
+      uint32_t chunk_size;                   // Size in bytes (must equal chunk_data length)
+   };
+
+   /**
+    * Upload several chunks of one file in a single action
+    * @param file_id - Parent file ID
+    * @param owner - Owner account
+    * @param chunks - Chunks to store (total data at most MAX_CHUNK_BATCH_BYTES)
+    */
+   [[eosio::action]]
+   void uploadchunks(
+      uint64_t file_id,
+      name owner,
+      std::vector<chunkupload> chunks
+   );
+
+   /**
+    * Move legacy artchunks rows into the file-scoped filechunks table
+    * (batched, decodes base64 rows). Moved rows are billed to the contract.
+    * @param max_rows - Maximum number of rows to move in this call
+    * @return true once artchunks is empty
+    */
+   [[eosio::action]]
+   bool migchunks(
+      uint32_t max_rows
+   );
+
+   /**
+    * Mark file upload as complete, moving the fileuploads progress into the
+    * artfile row
     * @param file_id - File ID to mark complete
     * @param owner - Owner account
     * @param total_chunks - Total number of chunks uploaded
+    * @param merkle_root - Root of the Merkle mountain range over the chunk
+    *                      sha256 hashes (checked for files that track one)
     */
    [[eosio::action]]
    void completefile(
       uint64_t file_id,
       name owner,
-      uint32_t total_chunks
+      uint32_t total_chunks,
+      checksum256 merkle_root
    );
 
+   /**
+    * Where one chunk of a manifest lives and how to check it
+    */
+   struct manifestchunk {
+      uint32_t chunk_index;                  // Primary key in the chunk scope
+      uint32_t chunk_size;                   // Bytes
+      checksum256 chunk_hash;                // sha256 of the data (zero for legacy rows)
+      uint32_t block_num;                    // Block holding the data (trace-only files, else 0)
+   };
+
+   /**
+    * A completed file's download plan
+    */
+   struct filemanifest {
+      uint64_t file_id;
+      uint64_t artwork_id;
+      name owner;
+      std::string filename_encrypted;
+      std::string mime_type;
+      uint64_t file_size;
+      checksum256 file_hash;
+      bool is_thumbnail;
+      std::string iv;
+      std::string encrypted_dek;             // Owner's DEK when the reader is the owner, else empty
+      std::string auth_tag;                  // Goes with encrypted_dek
+      std::vector<std::string> admin_encrypted_deks; // Candidate DEKs when the reader is an admin
+      uint8_t storage_mode;                  // STORAGE_MODE_*
+      uint64_t chunk_scope;                  // Scope of filechunks/chunkreceipts holding the chunks
+      uint32_t total_chunks;
+      std::vector<manifestchunk> chunks;     // In chunk_index order from start_index
+      uint32_t next_chunk_index;             // Pass as start_index to continue (total_chunks = done)
+   };
+
+   /**
+    * Download plan of a completed file in one call (read-only): metadata,
+    * the reader's wrapped DEK and the ordered chunk list (at most 256
+    * chunks per call)
+    * @param file_id - File to describe
+    * @param reader - Account that will decrypt; selects the DEK fields
+    * @param start_index - First chunk to list
+    * @return The manifest page
+    */
+   [[eosio::action, eosio::read_only]]
+   filemanifest getmanifest(uint64_t file_id, name reader, uint32_t start_index);
+
+   /**
+    * Consecutive chunk payloads of a file
+    */
+   struct chunkrange {
+      std::vector<char> data;                // Chunks start_index..next_chunk_index-1, concatenated
+      uint32_t next_chunk_index;             // Pass as start_index to continue (total_chunks = done)
+   };
+
+   /**
+    * Read a completed file's chunks in order (read-only), for streaming and
+    * ranged downloads. Stops before the chunk that would take the page over
+    * max_bytes, but always returns at least one chunk.
+    * @param file_id - File to read (table storage only)
+    * @param start_index - First chunk to return
+    * @param max_bytes - Data budget for this call (capped at 1MB)
+    * @return The data and the cursor for the next call
+    */
+   [[eosio::action, eosio::read_only]]
+   chunkrange readchunks(uint64_t file_id, uint32_t start_index, uint32_t max_bytes);
+
    /**
     * Set user quota limits
     * @param account - User account
@@ -106,6 +258,8 @@ public:
     * @param daily_size_limit - Daily size limit in bytes
     * @param weekly_file_limit - Weekly file count limit
     * @param weekly_size_limit - Weekly size limit in bytes
+    * @param ingest_rate - Optional chunk bytes per second (token bucket refill)
+    * @param ingest_burst - Optional bucket capacity in bytes (requires ingest_rate)
     */
    [[eosio::action]]
    void setquota(
@@ -114,7 +268,9 @@ public:
       uint32_t daily_file_limit,
       uint64_t daily_size_limit,
       uint32_t weekly_file_limit,
-      uint64_t weekly_size_limit
+      uint64_t weekly_size_limit,
+      binary_extension<uint64_t> ingest_rate,
+      binary_extension<uint64_t> ingest_burst
    );
 
    /**
@@ -122,9 +278,10 @@ public:
     * @param admin_account - Admin account
     * @param public_key - X25519 public key (base64)
     * @param description - Key description/purpose
+    * @return The allocated key ID
     */
    [[eosio::action]]
-   void addadminkey(
+   uint64_t addadminkey(
       name admin_account,
       std::string public_key,
       std::string description
@@ -148,46 +305,162 @@ public:
       std::string new_encrypted_dek
    );
 
+   /**
+    * One file's DEK for an addadmindeks batch
+    */
+   struct admindek {
+      uint64_t file_id;                      // File ID to update
+      std::string new_encrypted_dek;         // DEK encrypted with the new admin's public key
+   };
+
+   /**
+    * Append admin DEKs to up to 100 files in one action (for re-keying)
+    * @param deks - File IDs with their new admin DEKs
+    */
+   [[eosio::action]]
+   void addadmindeks(std::vector<admindek> deks);
+
+   /**
+    * One page of files still missing a DEK for an active admin key
+    */
+   struct missingdekpage {
+      std::vector<uint64_t> file_ids;        // Files with fewer admin DEKs than active keys
+      uint64_t next_file_id;                 // Pass as lower_bound to continue (0 = scan finished)
+   };
+
+   /**
+    * Page through files that still need a DEK for the newest admin key
+    * (read-only). Examines at most 1000 rows per call.
+    * @param lower_bound - First file ID to examine
+    * @param limit - Maximum number of file IDs to return
+    * @return Matching file IDs and the cursor for the next call
+    */
+   [[eosio::action, eosio::read_only]]
+   missingdekpage missingdeks(uint64_t lower_bound, uint32_t limit);
+
    /**
     * Log admin access to encrypted file (for audit trail)
     * @param admin_account - Admin accessing the file
     * @param file_id - File being accessed
     * @param reason - Reason for access
+    * @return The allocated log ID
     */
    [[eosio::action]]
-   void logaccess(
+   uint64_t logaccess(
       name admin_account,
       uint64_t file_id,
       std::string reason
    );
 
    /**
-    * Delete a single file and its chunks from an artwork
+    * Configure admin access logging
+    * @param trace_only - true: full record only in the action trace, RAM keeps a
+    *                     per-file ring of recent entries; false: legacy adminaccess table
+    * @param ring_size - Entries kept per file in trace-only mode
+    */
+   [[eosio::action]]
+   void setauditcfg(
+      bool trace_only,
+      uint32_t ring_size
+   );
+
+   struct limitsconfig;
+
+   /**
+    * Set the size limits every action validates against (contract owner only)
+    * @param limits - New limits; chunk and inline sizes are capped at
+    *                 MAX_CHUNK_BATCH_BYTES
+    */
+   [[eosio::action]]
+   void setlimits(limitsconfig limits);
+
+   /**
+    * Size limits in force (read-only); the defaults until setlimits is called
+    * @return Current limits
+    */
+   [[eosio::action, eosio::read_only]]
+   limitsconfig getlimits();
+
+   /**
+    * Erase rows from the legacy adminaccess table (batched)
+    * @param max_rows - Maximum number of rows to erase in this call
+    * @return true once the table is empty
+    */
+   [[eosio::action]]
+   bool pruneaccess(uint32_t max_rows);
+
+   struct storagestats;
+
+   /**
+    * Storage statistics (read-only)
+    * @return Row counts and payload bytes per table
+    */
+   [[eosio::action, eosio::read_only]]
+   storagestats getstats();
+
+   /**
+    * Set the storage statistics baseline (contract owner only). Rows written
+    * before the counters existed are not counted until ops sets the totals
+    * from an off-chain scan; filechunks scopes cannot be enumerated on chain.
+    * @param stats - Totals to store
+    */
+   [[eosio::action]]
+   void setstats(storagestats stats);
+
+   struct ownerusage;
+
+   /**
+    * Storage held by one owner (read-only)
+    * @param owner - Account to look up
+    * @return Artwork and file counts with complete and in-progress bytes
+    */
+   [[eosio::action, eosio::read_only]]
+   ownerusage getusage(name owner);
+
+   /**
+    * Rebuild an owner's usage row from artworks and artfiles (contract owner
+    * only). Used once per owner for rows written before usage was tracked.
+    * @param owner - Account to rebuild
+    */
+   [[eosio::action]]
+   void syncusage(name owner);
+
+   /**
+    * Delete a single file and its chunks from an artwork (resumable).
+    * Erases at most MAX_DELETE_ROWS rows per call; the file is marked as
+    * deleting on the first call so no further chunks land. Repeat until it
+    * returns true.
     * @param file_id - File ID to delete
     * @param artwork_id - Parent artwork ID
     * @param owner - Owner account (must match)
+    * @return true once the file row itself has been erased
     */
    [[eosio::action]]
-   void deletefile(
+   bool deletefile(
       uint64_t file_id,
       uint64_t artwork_id,
       name owner
    );
 
    /**
-    * Delete artwork and all associated files
+    * Delete artwork and all associated files (resumable).
+    * Erases at most MAX_DELETE_ROWS rows per call; the artwork is marked as
+    * deleting on the first call so no new files, completions, transfers or
+    * extras land. Repeat until it returns true.
     * @param artwork_id - Artwork ID to delete
     * @param owner - Owner account (must match)
+    * @return true once the artwork row itself has been erased
     */
    [[eosio::action]]
-   void deleteart(
+   bool deleteart(
       uint64_t artwork_id,
       name owner
    );
 
    /**
-    * Store artwork extras in action history (no RAM writes).
-    * The action trace is indexed by Hyperion and serves as the single source of truth.
+    * Store artwork extras in action history. The action trace is indexed by
+    * Hyperion and serves as the single source of truth; the artwork row only
+    * records the version, sha256 and block of the latest call.
     * @param artwork_id - Artwork ID
     * @param owner - Owner account (must match artwork owner)
     * @param extras_json - JSON string with extras (title, description_html, creation_date, era, artist_name, collection_name, file_order)
@@ -220,6 +493,76 @@ public:
       std::string memo
    );
 
+   /**
+    * Start a phased transfer for artworks with too many files for one
+    * transferart action. Locks the artwork (no file adds or deletes) until
+    * xferfinish or xfercancel.
+    * @param artwork_id - Artwork ID to transfer
+    * @param from - Current owner account
+    * @param to - Recipient account
+    * @param memo - Optional message from sender to recipient (recorded on-chain)
+    */
+   [[eosio::action]]
+   void xferbegin(uint64_t artwork_id, name from, name to, std::string memo);
+
+   /**
+    * Re-keyed DEK for one file of a phased transfer
+    */
+   struct filerekey {
+      uint64_t file_id;                      // Must be the next transferable file in byartwork order
+      std::string new_encrypted_dek;         // DEK re-encrypted for the recipient
+      std::string new_auth_tag;              // New ephemeral public key
+   };
+
+   /**
+    * Apply the next batch of re-keyed DEKs, walking the artwork's files in
+    * byartwork order from the transfer cursor. Files the sender does not own
+    * or that are being deleted are passed over; the batch's usage moves to
+    * the recipient right away.
+    * @param artwork_id - Artwork being transferred
+    * @param from - Current owner account
+    * @param files - Up to 50 entries, in file order
+    * @return true once every file of the artwork has been re-keyed
+    */
+   [[eosio::action]]
+   bool xferbatch(uint64_t artwork_id, name from, std::vector<filerekey> files);
+
+   /**
+    * Hand the artwork to the recipient once every transferable file has been
+    * re-keyed
+    * @param artwork_id - Artwork being transferred
+    * @param from - Current owner account
+    */
+   [[eosio::action]]
+   void xferfinish(uint64_t artwork_id, name from);
+
+   /**
+    * Abandon a phased transfer and unlock the artwork. Files already re-keyed
+    * stay with the recipient. Requires the sender or the contract account.
+    * @param artwork_id - Artwork being transferred
+    * @param from - Current owner account
+    */
+   [[eosio::action]]
+   void xfercancel(uint64_t artwork_id, name from);
+
+   /**
+    * Recompute an artwork's file aggregates from artfiles (contract owner
+    * only). Needed once for artworks created before the aggregates existed.
+    * @param artwork_id - Artwork ID
+    */
+   [[eosio::action]]
+   void syncart(uint64_t artwork_id);
+
+   /**
+    * Backfill the byownertime and bythumb indexes for rows written before
+    * they existed (contract owner only, batched). Rows are re-stored with
+    * the contract as RAM payer.
+    * @param max_rows - Maximum number of rows to re-store in this call
+    * @return true once every artworks and artfiles row has been re-stored
+    */
+   [[eosio::action]]
+   bool reindex(uint32_t max_rows);
+
    // ========== TABLES ==========
 
    /**
@@ -234,17 +577,42 @@ public:
       std::string creator_public_key;        // Creator's X25519 public key
       uint64_t created_at;                   // Creation timestamp
       uint32_t file_count;                   // Number of associated files
+      binary_extension<bool> deleting;       // Paginated deleteart in progress
+
+      // Aggregates over the artwork's files (absent on rows from before they
+      // were tracked until syncart fills them in)
+      binary_extension<uint64_t> total_bytes;        // Sum of file_size
+      binary_extension<uint32_t> completed_files;    // Files with upload_complete set
+      binary_extension<uint64_t> thumbnail_file_id;  // Completed is_thumbnail file with the highest ID (0 = none)
+
+      // Latest setextras call (absent until the first one)
+      binary_extension<uint32_t> extras_version;     // setextras calls so far
+      binary_extension<checksum256> extras_hash;     // sha256 of the latest extras_json
+      binary_extension<uint32_t> extras_block;       // Block holding the latest setextras
 
       uint64_t primary_key() const { return artwork_id; }
       uint64_t by_owner() const { return owner.value; }
+      uint128_t by_owner_time() const {
+         return (uint128_t{owner.value} << 64) | created_at;
+      }
    };
 
    using artworks_table = multi_index<
       "artworks"_n,
       artwork,
-      indexed_by<"byowner"_n, const_mem_fun<artwork, uint64_t, &artwork::by_owner>>
+      indexed_by<"byowner"_n, const_mem_fun<artwork, uint64_t, &artwork::by_owner>>,
+      indexed_by<"byownertime"_n, const_mem_fun<artwork, uint128_t, &artwork::by_owner_time>>
    >;
 
+   /**
+    * Streaming Merkle accumulator over a file's chunk hashes: a Merkle
+    * mountain range folded in chunk_index order
+    */
+   struct merkleacc {
+      uint32_t leaf_count;                   // Chunks folded so far (indices 0..leaf_count-1)
+      std::vector<checksum256> peaks;        // Perfect subtree roots, largest first
+   };
+
    /**
     * Files table - stores file metadata with encrypted DEKs
     */
@@ -266,30 +634,120 @@ public:
       bool upload_complete;                  // Upload completion flag
       uint64_t created_at;                   // Creation timestamp
       uint64_t completed_at;                 // Completion timestamp
+      binary_extension<bool> deleting;       // Paginated delete in progress
+      binary_extension<std::vector<uint8_t>> chunk_bitmap; // Received chunk indices (bit i = chunk_index i)
+      binary_extension<merkleacc> chunk_merkle;            // Accumulator over chunk hashes
+      binary_extension<uint8_t> storage_mode;              // STORAGE_MODE_* (absent = table)
+      binary_extension<uint64_t> chunk_file_id;            // Scope holding the chunks (absent or 0 = file_id)
 
       uint64_t primary_key() const { return file_id; }
       uint64_t by_artwork() const { return artwork_id; }
       uint64_t by_owner() const { return owner.value; }
+      uint128_t by_thumb() const {
+         return (uint128_t{artwork_id} << 64) | (is_thumbnail ? 1 : 0);
+      }
    };
 
    using artfiles_table = multi_index<
       "artfiles"_n,
       artfile,
       indexed_by<"byartwork"_n, const_mem_fun<artfile, uint64_t, &artfile::by_artwork>>,
-      indexed_by<"byowner"_n, const_mem_fun<artfile, uint64_t, &artfile::by_owner>>
+      indexed_by<"byowner"_n, const_mem_fun<artfile, uint64_t, &artfile::by_owner>>,
+      indexed_by<"bythumb"_n, const_mem_fun<artfile, uint128_t, &artfile::by_thumb>>
    >;
 
    /**
-    * Chunks table - stores encrypted file chunks
+    * Upload progress of a file that is still taking chunks (scope: contract).
+    * Kept apart from the artfile row so a chunk upload rewrites only this
+    * small row; completefile moves it into the artfile row and erases it.
+    */
+   struct [[eosio::table]] fileupload {
+      uint64_t file_id;                      // Primary key
+      uint32_t uploaded_chunks;              // Chunks received so far
+      std::vector<uint8_t> chunk_bitmap;     // Received chunk indices (bit i = chunk_index i)
+      merkleacc chunk_merkle;                // Accumulator over chunk hashes
+      uint32_t pending_chunks;               // Received chunks not yet counted in stats
+      uint64_t pending_bytes;                // Their bytes
+
+      uint64_t primary_key() const { return file_id; }
+   };
+
+   using fileuploads_table = multi_index<"fileuploads"_n, fileupload>;
+
+   /**
+    * File chunks table - encrypted chunks of one file (scope: file_id)
+    * Keyed by chunk_index, so a file reads back as one primary-key range.
+    */
+   struct [[eosio::table]] filechunk {
+      uint32_t chunk_index;                  // Primary key (zero-based index)
+      uint32_t chunk_size;                   // Chunk size in bytes
+      uint64_t uploaded_at;                  // Upload timestamp
+      std::vector<char> chunk_data;          // Encrypted chunk data (raw bytes)
+      binary_extension<checksum256> chunk_hash; // sha256 of chunk_data
+
+      uint64_t primary_key() const { return chunk_index; }
+   };
+
+   using filechunks_table = multi_index<"filechunks"_n, filechunk>;
+
+   /**
+    * Chunk receipts table - chunks of a trace-only file (scope: file_id)
+    * The data itself is not stored; it stays in the upload action recorded
+    * in block block_num.
+    */
+   struct [[eosio::table]] chunkreceipt {
+      uint32_t chunk_index;                  // Primary key (zero-based index)
+      uint32_t chunk_size;                   // Chunk size in bytes
+      checksum256 chunk_hash;                // sha256 of the chunk data
+      uint32_t block_num;                    // Block containing the upload action
+
+      uint64_t primary_key() const { return chunk_index; }
+   };
+
+   using chunkreceipts_table = multi_index<"chunkreceipts"_n, chunkreceipt>;
+
+   /**
+    * Size and hash of each filechunks row (scope: chunk scope), written
+    * alongside it and erased with it. getmanifest and the Merkle fold read
+    * these small rows instead of loading chunk data.
+    */
+   struct [[eosio::table]] chunkmeta {
+      uint32_t chunk_index;                  // Primary key (zero-based index)
+      uint32_t chunk_size;                   // Chunk size in bytes
+      checksum256 chunk_hash;                // sha256 of the chunk data
+
+      uint64_t primary_key() const { return chunk_index; }
+   };
+
+   using chunkmetas_table = multi_index<"chunkmetas"_n, chunkmeta>;
+
+   /**
+    * Chunk reference counts (scope: contract). A row exists only while more
+    * than one file reads the chunks of a scope; its chunks are erased when
+    * the last of them is deleted.
+    */
+   struct [[eosio::table]] chunkref {
+      uint64_t chunk_file_id;                // Primary key (filechunks/chunkreceipts scope)
+      uint32_t refs;                         // Files sharing the scope (at least 2)
+
+      uint64_t primary_key() const { return chunk_file_id; }
+   };
+
+   using chunkrefs_table = multi_index<"chunkrefs"_n, chunkref>;
+
+   /**
+    * Legacy chunks table - no longer written; migchunks drains it into filechunks
     */
    struct [[eosio::table]] artchunk {
       uint64_t chunk_id;                     // Primary key
       uint64_t file_id;                      // Parent file
       name owner;                            // Owner account
       uint32_t chunk_index;                  // Zero-based index
-      std::string chunk_data;                // Encrypted chunk data (base64)
+      std::string chunk_data;                // Legacy encrypted chunk data (base64), empty once raw
       uint32_t chunk_size;                   // Chunk size in bytes
       uint64_t uploaded_at;                  // Upload timestamp
+      binary_extension<uint8_t> format_version;        // CHUNK_FORMAT_* (absent = base64)
+      binary_extension<std::vector<char>> chunk_bytes; // Encrypted chunk data (raw bytes)
 
       uint64_t primary_key() const { return chunk_id; }
       uint64_t by_file() const { return file_id; }
@@ -328,6 +786,13 @@ public:
       uint64_t weekly_size_used;             // Bytes used this week
       uint64_t weekly_reset_at;              // Weekly reset timestamp (Monday 00:00 UTC)
 
+      // Chunk ingest token bucket (absent on rows from before throttling;
+      // filled in with the defaults on first upload)
+      binary_extension<uint64_t> ingest_rate;       // Bytes refilled per second
+      binary_extension<uint64_t> ingest_burst;      // Bucket capacity in bytes
+      binary_extension<uint64_t> ingest_tokens;     // Bytes available at ingest_updated_ms
+      binary_extension<uint64_t> ingest_updated_ms; // Block time of the last refill (ms)
+
       uint64_t primary_key() const { return account.value; }
    };
 
@@ -376,13 +841,316 @@ public:
       indexed_by<"byadmin"_n, const_mem_fun<adminaccesslog, uint64_t, &adminaccesslog::by_admin>>
    >;
 
+   /**
+    * Recent admin access ring - scope is file_id, at most ring_size rows
+    * (oldest log_id evicted first). Used in trace-only audit mode.
+    */
+   using accessring_table = multi_index<"accessring"_n, adminaccesslog>;
+
+   /**
+    * Audit logging configuration (singleton)
+    */
+   struct [[eosio::table]] auditconfig {
+      bool trace_only;                       // Full records in action trace only (opt-in)
+      uint32_t ring_size;                    // Ring entries kept per file
+   };
+
+   using auditconfig_singleton = singleton<"auditcfg"_n, auditconfig>;
+
+   /**
+    * Size limits (singleton) - tunable without a redeploy. Tier fields
+    * follow usagequota::tier; accounts without a quota row are free tier.
+    */
+   struct [[eosio::table]] limitsconfig {
+      uint64_t max_file_size;                // Free tier bytes per file
+      uint64_t premium_max_file_size;        // Premium tier bytes per file
+      uint32_t max_chunk_size;               // Free tier bytes per chunk
+      uint32_t premium_max_chunk_size;       // Premium tier bytes per chunk
+      uint32_t max_inline_size;              // addfile inline_data bytes
+      uint32_t max_title_size;               // createart title_encrypted
+      uint32_t max_text_size;                // createart description/metadata
+      uint32_t max_filename_size;            // addfile filename_encrypted
+      uint32_t max_extras_size;              // setextras extras_json
+      uint32_t default_daily_file_limit;     // Quota given to accounts without a usagequotas row
+      uint64_t default_daily_size_limit;
+      uint32_t default_weekly_file_limit;
+      uint64_t default_weekly_size_limit;
+   };
+
+   using limits_singleton = singleton<"limits"_n, limitsconfig>;
+
+   /**
+    * Contract state - monotonic ID counters (singleton)
+    * Each counter holds the next unused ID for its table.
+    */
+   struct [[eosio::table]] globalstate {
+      uint64_t next_artwork_id;              // Next artworks primary key
+      uint64_t next_file_id;                 // Next artfiles primary key
+      uint64_t next_key_id;                  // Next adminkeys primary key
+      uint64_t next_log_id;                  // Next adminaccess primary key
+   };
+
+   using globalstate_singleton = singleton<"state"_n, globalstate>;
+
+   /**
+    * Active admin keys (singleton) - kept current by addadminkey/rmadminkey
+    * so DEK-count checks never scan adminkeys.
+    */
+   struct [[eosio::table]] adminkeyset {
+      uint32_t active_count;                 // Number of active admin keys
+      std::vector<uint64_t> active_key_ids;  // Active key IDs, ascending
+   };
+
+   using adminkeyset_singleton = singleton<"keyset"_n, adminkeyset>;
+
+   /**
+    * Progress of the reindex backfill (singleton)
+    */
+   struct [[eosio::table]] reindexstate {
+      uint64_t next_artwork_id;              // First artworks row not yet re-stored
+      uint64_t next_file_id;                 // First artfiles row not yet re-stored
+      bool done;                             // Both tables finished
+   };
+
+   using reindexstate_singleton = singleton<"reindex"_n, reindexstate>;
+
+   /**
+    * Storage statistics (singleton) - kept current by every path that
+    * emplaces or erases the counted rows
+    */
+   struct [[eosio::table]] storagestats {
+      uint64_t artworks;                     // artworks rows
+      uint64_t files;                        // artfiles rows
+      uint64_t file_bytes;                   // Sum of artfiles::file_size
+      uint64_t chunks;                       // filechunks + artchunks rows (in-flight uploads once completed or deleted)
+      uint64_t chunk_bytes;                  // Chunk data held in RAM
+      uint64_t receipts;                     // chunkreceipts rows (likewise)
+      uint64_t receipt_bytes;                // Chunk data of trace-only files (not in RAM)
+      uint64_t access_logs;                  // accessring + adminaccess rows
+   };
+
+   using storagestats_singleton = singleton<"stats"_n, storagestats>;
+
+   /**
+    * Per-owner storage usage - updated as artworks and files are added,
+    * completed, deleted and transferred; erased when it drops to zero
+    */
+   struct [[eosio::table]] ownerusage {
+      name owner;                            // Primary key
+      uint64_t artworks;                     // Artworks owned
+      uint64_t files;                        // Files owned
+      uint64_t complete_bytes;               // Declared size of completed files
+      uint64_t pending_bytes;                // Declared size of files still uploading
+
+      uint64_t primary_key() const { return owner.value; }
+   };
+
+   using ownerusage_table = multi_index<"ownerusage"_n, ownerusage>;
+
+   /**
+    * Phased transfers in progress - one row per locked artwork. Files and
+    * their usage are handed to the recipient batch by batch; the artwork
+    * itself changes owner in xferfinish.
+    */
+   struct [[eosio::table]] pendingxfer {
+      uint64_t artwork_id;                   // Primary key
+      name from;                             // Current owner
+      name to;                               // Recipient
+      uint64_t last_file_id;                 // Cursor: last re-keyed file (0 = none yet)
+      uint32_t files_done;                   // Files re-keyed so far
+      uint64_t complete_bytes;               // Declared size of re-keyed completed files
+      uint64_t pending_bytes;                // Declared size of re-keyed uploading files
+      uint64_t started_at;                   // xferbegin timestamp
+
+      uint64_t primary_key() const { return artwork_id; }
+   };
+
+   using pendingxfers_table = multi_index<"transfers"_n, pendingxfer>;
+
 private:
+   /**
+    * Load the ID counters, seeding them from the tables on first use
+    * @return Current counters
+    */
+   globalstate load_state();
+
+   /**
+    * Persist the ID counters
+    * @param state - Counters to store
+    */
+   void save_state(const globalstate& state);
+
+   /**
+    * Take an ID from a counter, or accept a caller-chosen one
+    * @param counter - Counter to allocate from (advanced past the result)
+    * @param requested - Caller-chosen ID, or 0 to allocate
+    * @return The ID to use
+    */
+   static uint64_t take_id(uint64_t& counter, uint64_t requested);
+
+   /**
+    * Load the storage statistics (all zero before first use)
+    * @return Current statistics
+    */
+   storagestats load_stats();
+
+   /**
+    * Persist the storage statistics
+    * @param stats - Statistics to store
+    */
+   void save_stats(const storagestats& stats);
+
+   /**
+    * Lower a statistics counter, stopping at zero for rows that predate it
+    * @param counter - Counter to lower
+    * @param amount - Amount to subtract
+    */
+   static void decrease(uint64_t& counter, uint64_t amount);
+
+   /**
+    * Apply signed deltas to an owner's usage row (billed to the contract)
+    * @param owner - Account whose usage changes
+    * @param artworks - Change in artworks owned
+    * @param files - Change in files owned
+    * @param complete_bytes - Change in completed bytes
+    * @param pending_bytes - Change in in-progress bytes
+    */
+   void change_usage(name owner, int64_t artworks, int64_t files, int64_t complete_bytes, int64_t pending_bytes);
+
+   /**
+    * Remove an erased file from its owner's usage row
+    * @param file - File row about to be erased
+    */
+   void release_file_usage(const artfile& file);
+
+   /**
+    * Recompute an artwork's file count and aggregates from artfiles,
+    * filling the extension fields
+    * @param row - Artwork row being modified
+    */
+   void fill_artwork_aggregates(artwork& row);
+
+   /**
+    * Pick the artwork's thumbnail after one of its files goes away: the
+    * completed is_thumbnail file with the highest file_id, the same rule
+    * addfile, completefile and fill_artwork_aggregates apply
+    * @param artwork_id - Artwork ID
+    * @param excluded_file_id - File being deleted
+    * @return File ID, or 0 if the artwork has no other completed thumbnail
+    */
+   uint64_t next_thumbnail(uint64_t artwork_id, uint64_t excluded_file_id);
+
+   /**
+    * Whether reindex has given every existing row its byownertime and
+    * bythumb entries
+    */
+   bool reindex_done();
+
+   /**
+    * Fail if the artwork is locked by a phased transfer
+    * @param artwork_id - Artwork ID
+    */
+   void require_no_transfer(uint64_t artwork_id);
+
+   /**
+    * Change an artwork's owner. Rows the reindex backfill has not reached yet
+    * have no byownertime entry, which modify cannot re-key, so those are
+    * re-stored instead.
+    * @param artworks - Artworks table
+    * @param artwork_itr - Artwork row
+    * @param to - New owner
+    */
+   void set_artwork_owner(artworks_table& artworks, artworks_table::const_iterator artwork_itr, name to);
+
+   using artfiles_by_artwork = decltype(std::declval<artfiles_table>().get_index<"byartwork"_n>());
+
+   /**
+    * Position of the next file a phased transfer has to re-key
+    * @param artfiles - Files table
+    * @param by_artwork - byartwork index of artfiles
+    * @param transfer - Transfer in progress
+    * @return Iterator into by_artwork (past the artwork's files when done)
+    */
+   artfiles_by_artwork::const_iterator next_transfer_file(
+      artfiles_table& artfiles,
+      const artfiles_by_artwork& by_artwork,
+      const pendingxfer& transfer
+   );
+
+   /**
+    * Move past files of the transferred artwork that the sender does not own
+    * (left with a previous owner by a transferart that did not list them) or
+    * that deletefile has tombstoned
+    * @param by_artwork - byartwork index of artfiles
+    * @param file_itr - First candidate file
+    * @param transfer - Transfer in progress
+    * @return First transferable file at or after file_itr, or past the artwork's files
+    */
+   artfiles_by_artwork::const_iterator skip_untransferable_files(
+      const artfiles_by_artwork& by_artwork,
+      artfiles_by_artwork::const_iterator file_itr,
+      const pendingxfer& transfer
+   );
+
    /**
     * Check and update quota usage for a file upload
     * @param account - User account
     * @param file_size - File size in bytes
+    * @param limits - Limits in force (default quota for new accounts)
     */
-   void check_and_update_quota(name account, uint64_t file_size);
+   void check_and_update_quota(name account, uint64_t file_size, const limitsconfig& limits);
+
+   /**
+    * Limits in force: the stored singleton, or the built-in defaults
+    */
+   limitsconfig load_limits();
+
+   /**
+    * Built-in limits used until setlimits is called
+    */
+   static limitsconfig default_limits();
+
+   /**
+    * Quota tier of an account (0 without a quota row)
+    */
+   uint8_t account_tier(name account);
+
+   /**
+    * Whether an account holds an active admin key
+    */
+   bool has_active_admin_key(name account);
+
+   /**
+    * Locate one chunk of a completed file for getmanifest. Table chunks are
+    * described by their chunkmetas row, so no chunk data is loaded.
+    * @param scope - Chunk scope of the file
+    * @param storage_mode - File's STORAGE_MODE_*
+    * @param file_id - File ID (legacy artchunks rows are keyed by it)
+    * @param chunk_index - Chunk to locate
+    */
+   manifestchunk manifest_chunk(uint64_t scope, uint8_t storage_mode, uint64_t file_id, uint32_t chunk_index);
+
+   /**
+    * Append one table-stored chunk's data to out for readchunks, reading
+    * filechunks or a legacy artchunks row
+    * @param scope - Chunk scope of the file
+    * @param file_id - File ID (legacy artchunks rows are keyed by it)
+    * @param chunk_index - Chunk to read
+    * @param max_bytes - Skip the chunk unless it fits in this many bytes
+    * @return Bytes appended (0 if the chunk did not fit)
+    */
+   uint32_t append_chunk_data(std::vector<char>& out, uint64_t scope, uint64_t file_id, uint32_t chunk_index, uint64_t max_bytes);
+
+   /**
+    * Largest file an account may add. The tier is only looked up when the
+    * tiers' limits differ.
+    */
+   uint64_t file_size_limit(const limitsconfig& limits, name owner);
+
+   /**
+    * Largest chunk an account may upload; tier looked up as for file_size_limit
+    */
+   uint32_t chunk_size_limit(const limitsconfig& limits, name owner);
 
    /**
     * Reset quota counters if periods have expired
@@ -393,10 +1161,193 @@ private:
    bool reset_quota_if_expired(usagequota& quota, uint64_t current_time);
 
    /**
-    * Get all active admin public keys
-    * @return Vector of active admin public keys
+    * Refill an account's chunk ingest bucket from the block clock and take
+    * bytes from it; fails when the bucket holds fewer than bytes
+    * @param account - File owner the chunks are charged to
+    * @param bytes - Chunk bytes in this action
+    */
+   void take_ingest_tokens(name account, uint64_t bytes);
+
+   /**
+    * Refill a quota row's token bucket up to the given block time
+    * @param quota - Quota row (missing bucket fields get the defaults)
+    * @param now_ms - Current block time in milliseconds
+    */
+   static void refill_ingest_bucket(usagequota& quota, uint64_t now_ms);
+
+   /**
+    * Load the active admin key set, building it from adminkeys on first use
+    * @return Active admin key set
+    */
+   adminkeyset load_admin_keyset();
+
+   /**
+    * Build the active admin key set by scanning adminkeys, without storing it
+    * (for read-only actions, which cannot write the singleton)
+    * @return Active admin key set
+    */
+   adminkeyset scan_admin_keys();
+
+   /**
+    * Get the number of active admin keys
+    * @return Active admin key count
+    */
+   uint32_t active_admin_key_count();
+
+   /**
+    * Verify a file accepts chunk uploads from owner: neither the file nor
+    * its artwork may be being deleted
+    * @param artfiles - Files table
+    * @param file_id - File ID
+    * @param owner - Expected owner
+    * @return Iterator to the file row
+    */
+   artfiles_table::const_iterator require_uploadable_file(artfiles_table& artfiles, uint64_t file_id, name owner);
+
+   /**
+    * Validate and store one chunk row, or only its receipt for a trace-only
+    * file (does not touch the file row)
+    * @param chunks - The file's filechunks table
+    * @param ram_payer - RAM payer for the new row
+    * @param file_id - Parent file ID
+    * @param storage_mode - File's STORAGE_MODE_*
+    * @param chunk - Chunk to store; its data is moved into the row
+    * @param max_chunk_size - Largest chunk_size allowed
+    * @param received - File's received-chunk bitmap to check and update, or
+    *                   nullptr for a legacy file (row lookups in both tables)
+    * @return sha256 of the chunk data
+    */
+   checksum256 store_chunk(filechunks_table& chunks, name ram_payer, uint64_t file_id, uint8_t storage_mode, chunkupload& chunk, uint32_t max_chunk_size, std::vector<uint8_t>* received);
+
+   /**
+    * Whether uploads to a file are tracked in its chunk bitmap. Files that
+    * already held chunks before the bitmap existed are not.
+    * @param file - File row
+    * @return true if the bitmap is authoritative for this file
+    */
+   static bool tracks_chunk_bitmap(const artfile& file);
+
+   /**
+    * Whether a file keeps a Merkle accumulator over its chunk hashes. Files
+    * that already held chunks before the accumulator existed do not.
+    * @param file - File row
+    * @return true if completefile checks the Merkle root for this file
+    */
+   static bool tracks_chunk_merkle(const artfile& file);
+
+   /**
+    * Upload progress of an in-flight file: its fileuploads row, or what the
+    * artfile row holds for a file with no such row yet
+    * @param uploads - fileuploads table
+    * @param file - File row
+    * @return The progress (pending counters zero when taken from the file row)
+    */
+   static fileupload load_upload_progress(const fileuploads_table& uploads, const artfile& file);
+
+   /**
+    * Write a file's upload progress row, creating it on the first chunk
+    * @param uploads - fileuploads table
+    * @param progress - Progress to store
+    * @param ram_payer - RAM payer for the row
+    */
+   static void save_upload_progress(fileuploads_table& uploads, const fileupload& progress, name ram_payer);
+
+   /**
+    * Erase a file's upload progress row if it has one, adding the chunks it
+    * had not yet counted to stats
+    * @param file - File row
+    * @param stats - Stats to update
+    */
+   void drop_upload_progress(const artfile& file, storagestats& stats);
+
+   /**
+    * Store a file's chunk bitmap and accumulator, filling earlier extension fields
+    * @param row - File row being modified
+    * @param bitmap - New bitmap
+    * @param merkle - New accumulator, or nullptr if the file does not keep one
+    */
+   static void set_upload_progress(artfile& row, std::vector<uint8_t>&& bitmap, const merkleacc* merkle);
+
+   /**
+    * Fold every chunk that directly follows the accumulator into it
+    * @param file_id - File ID (hashes of earlier actions' chunks are read from its scope)
+    * @param storage_mode - File's STORAGE_MODE_*
+    * @param received - File's received-chunk bitmap
+    * @param merkle - Accumulator to advance
+    * @param fresh - (chunk_index, hash) of chunks stored by this action
+    */
+   void fold_chunk_hashes(uint64_t file_id, uint8_t storage_mode, const std::vector<uint8_t>& received, merkleacc& merkle, const std::vector<std::pair<uint32_t, checksum256>>& fresh);
+
+   /**
+    * Append one leaf to a Merkle mountain range
+    * @param merkle - Accumulator
+    * @param leaf - Leaf hash (sha256 of the chunk)
+    */
+   static void merkle_append(merkleacc& merkle, const checksum256& leaf);
+
+   /**
+    * Root of a Merkle mountain range, bagging the peaks right to left
+    * @param peaks - Peaks, largest first (must not be empty)
+    * @return Root hash
+    */
+   static checksum256 merkle_bag(const std::vector<checksum256>& peaks);
+
+   /**
+    * Hash of an interior node
+    * @param left - Left child
+    * @param right - Right child
+    * @return sha256(left || right)
+    */
+   static checksum256 hash_pair(const checksum256& left, const checksum256& right);
+
+   /**
+    * Check whether a bit is set in a received-chunk bitmap
+    * @param bitmap - Received-chunk bitmap
+    * @param index - Chunk index
+    * @return true if chunk_index was received
+    */
+   static bool bitmap_has(const std::vector<uint8_t>& bitmap, uint32_t index);
+
+   /**
+    * Check whether a bitmap has exactly bits 0..count-1 set
+    * @param bitmap - Received-chunk bitmap
+    * @param count - Expected number of chunks
+    * @return true if exactly indices 0..count-1 are present
+    */
+   static bool bitmap_is_prefix(const std::vector<uint8_t>& bitmap, uint32_t count);
+
+   /**
+    * Erase chunk rows of a file (filechunks and chunkreceipts scopes, then
+    * legacy artchunks rows), within a row budget
+    * @param file_id - File whose chunks to erase
+    * @param budget - Rows still allowed this call (decremented per erase)
+    * @param stats - Storage statistics to update
+    * @return true if no chunks of the file remain
+    */
+   bool erase_file_chunks(uint64_t file_id, uint32_t& budget, storagestats& stats);
+
+   /**
+    * Scope holding a file's chunks: its own file_id unless it shares another's
+    */
+   static uint64_t chunk_scope(const artfile& file);
+
+   /**
+    * Drop a file's hold on its chunks before the file row is erased, along
+    * with its access ring. Shared chunks lose one reference; otherwise they
+    * are erased as by erase_file_chunks.
+    * @param file - File being deleted
+    * @param budget - Rows still allowed this call (decremented per erase)
+    * @param stats - Storage statistics to update
+    * @return true if the file no longer holds any chunks
+    */
+   bool release_file_chunks(const artfile& file, uint32_t& budget, storagestats& stats);
+
+   /**
+    * Decode standard base64 (with optional padding)
+    * @param input - Base64 text
+    * @return Decoded bytes
     */
-   std::vector<std::string> get_active_admin_keys();
+   static std::vector<char> decode_base64(const std::string& input);
 
    /**
     * Calculate next Monday 00:00 UTC timestamp
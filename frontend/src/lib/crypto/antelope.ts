@@ -369,13 +369,15 @@ export async function addDeviceKey(publicKey: string): Promise<{ added: boolean
 /**
  * Sign and push a transaction for a contract action.
  * Used by the browser to sign createart and addfile transactions.
+ * `return_value` is the action's return value (e.g. the ID that createart
+ * and addfile allocate when passed 0).
  */
 export async function signAndPushTransaction(
   actionName: string,
   data: Record<string, unknown>,
   signerAccount: string,
   privateKeyWif: string
-): Promise<{ transaction_id: string }> {
+): Promise<{ transaction_id: string; return_value: unknown }> {
   const privateKey = PrivateKey.from(privateKeyWif);
   const info = await getChainInfoDirect();
   const abi = await getContractAbi();
@@ -417,5 +419,8 @@ export async function signAndPushTransaction(
     serializedTransaction: serializedHex,
   });
 
-  return { transaction_id: result.transaction_id };
+  return {
+    transaction_id: result.transaction_id,
+    return_value: result.processed?.action_traces?.[0]?.return_value_data,
+  };
 }
@@ -9,6 +9,35 @@ import { useUploadStore } from '@/store/upload';
 import { generateThumbnail, generatePublicThumbnail } from './thumbnail';
 import { uploadPublicThumbnail, saveArtworkTxId } from '@/lib/api/profile';
 
+// Contract max_inline_size (default limits): ciphertext up to this size can
+// ride along in addfile, which stores the file complete without
+// uploadchunk/completefile
+const MAX_INLINE_SIZE = 65536;
+
+/**
+ * Extra addfile fields that inline a small (thumbnail) payload.
+ * Returns no fields when the ciphertext is too large to inline.
+ */
+function inlinePayload(ciphertext: Uint8Array): Record<string, unknown> {
+  if (ciphertext.length > MAX_INLINE_SIZE) return {};
+  return {
+    storage_mode: 0, // earlier binary extension must be present
+    inline_data: Array.from(ciphertext, (b) => b.toString(16).padStart(2, '0')).join(''),
+  };
+}
+
+/**
+ * ID allocated by createart/addfile (called with ID 0), from the action's
+ * return value
+ */
+function allocatedId(result: { return_value: unknown }, action: string): number {
+  const id = Number(result.return_value);
+  if (!Number.isSafeInteger(id) || id <= 0) {
+    throw new Error(`${action} did not return an ID`);
+  }
+  return id;
+}
+
 /**
  * Wait for an artwork to appear on-chain after createart tx.
  * Polls the artworks table every 2s, up to 30s (6 block intervals).
@@ -104,10 +133,6 @@ export async function uploadArtwork(opts: UploadOptions): Promise<{
     const encrypted = await encryptFile(fileBuffer, recipientKeys);
     console.log('[upload] Encryption complete, nonce:', encrypted.nonce.length, 'chars (base64)');
 
-    // 2. Generate unique IDs for artwork and file
-    const artworkId = Date.now();
-    const fileId = artworkId + 1;
-
     // 3. Sign & push `createart` tx from browser
     store.startUpload(tempId, 3); // 3 steps: createart, addfile, upload
     store.updateProgress(tempId, 0);
@@ -122,7 +147,7 @@ export async function uploadArtwork(opts: UploadOptions): Promise<{
     const createartResult = await signAndPushTransaction(
       'createart',
       {
-        artwork_id: artworkId,
+        artwork_id: 0, // allocated by the contract
         owner: opts.blockchainAccount,
         title_encrypted: btoa(opts.title),
         description_encrypted: descriptionEncoded,
@@ -132,6 +157,7 @@ export async function uploadArtwork(opts: UploadOptions): Promise<{
       opts.blockchainAccount,
       antelopeKey.privateKey
     );
+    const artworkId = allocatedId(createartResult, 'createart');
 
     store.updateProgress(tempId, 1);
 
@@ -153,10 +179,10 @@ export async function uploadArtwork(opts: UploadOptions): Promise<{
       hashBytes[i] = parseInt(encrypted.hash.slice(i * 2, i * 2 + 2), 16);
     }
 
-    await signAndPushTransaction(
+    const addfileResult = await signAndPushTransaction(
       'addfile',
       {
-        file_id: fileId,
+        file_id: 0, // allocated by the contract
         artwork_id: artworkId,
         owner: opts.blockchainAccount,
         filename_encrypted: btoa(opts.file.name),
@@ -172,6 +198,7 @@ export async function uploadArtwork(opts: UploadOptions): Promise<{
       opts.blockchainAccount,
       antelopeKey.privateKey
     );
+    const fileId = allocatedId(addfileResult, 'addfile');
 
     store.updateProgress(tempId, 2);
 
@@ -193,13 +220,12 @@ export async function uploadArtwork(opts: UploadOptions): Promise<{
     // Generate and upload thumbnail for PDF/text files (best-effort, non-blocking)
     generateThumbnail(opts.file).then(async (thumb) => {
       if (!thumb) return;
-      const thumbId = fileId + 1;
       const thumbBuffer = await thumb.arrayBuffer();
       const thumbEncrypted = await encryptFile(thumbBuffer, recipientKeys);
-      await signAndPushTransaction(
+      const thumbResult = await signAndPushTransaction(
         'addfile',
         {
-          file_id: thumbId,
+          file_id: 0, // allocated by the contract
           artwork_id: artworkId,
           owner: opts.blockchainAccount,
           filename_encrypted: btoa(thumb.name),
@@ -211,10 +237,12 @@ export async function uploadArtwork(opts: UploadOptions): Promise<{
           iv: thumbEncrypted.nonce,
           auth_tag: thumbEncrypted.encryptedDeks[0].ephemeralPublicKey,
           is_thumbnail: true,
+          ...inlinePayload(thumbEncrypted.ciphertext),
         },
         opts.blockchainAccount,
         antelopeKey.privateKey
       );
+      const thumbId = allocatedId(thumbResult, 'addfile');
       await uploadStart({
         artwork_id: artworkId,
         file_id: thumbId,
@@ -275,17 +303,14 @@ export async function addFileToArtwork(opts: AddFileOptions): Promise<{ fileId:
     const fileBuffer = await opts.file.arrayBuffer();
     const encrypted = await encryptFile(fileBuffer, recipientKeys);
 
-    // Generate unique file ID
-    const fileId = Date.now();
-
     store.startUpload(tempId, 2); // 2 steps: addfile tx, upload
     store.updateProgress(tempId, 0);
 
     // Sign & push addfile tx only (artwork already exists)
-    await signAndPushTransaction(
+    const addfileResult = await signAndPushTransaction(
       'addfile',
       {
-        file_id: fileId,
+        file_id: 0, // allocated by the contract
         artwork_id: opts.artworkId,
         owner: opts.blockchainAccount,
         filename_encrypted: btoa(opts.file.name),
@@ -301,6 +326,7 @@ export async function addFileToArtwork(opts: AddFileOptions): Promise<{ fileId:
       opts.blockchainAccount,
       antelopeKey.privateKey
     );
+    const fileId = allocatedId(addfileResult, 'addfile');
 
     store.updateProgress(tempId, 1);
 
@@ -322,14 +348,13 @@ export async function addFileToArtwork(opts: AddFileOptions): Promise<{ fileId:
     // Generate and upload thumbnail for PDF/text files (best-effort, non-blocking)
     generateThumbnail(opts.file).then(async (thumb) => {
       if (!thumb) return;
-      const thumbId = fileId + 1;
       const recipientKeys = [keyPair!.publicKey, ...(opts.adminPublicKeys || [])];
       const thumbBuffer = await thumb.arrayBuffer();
       const thumbEncrypted = await encryptFile(thumbBuffer, recipientKeys);
-      await signAndPushTransaction(
+      const thumbResult = await signAndPushTransaction(
         'addfile',
         {
-          file_id: thumbId,
+          file_id: 0, // allocated by the contract
           artwork_id: opts.artworkId,
           owner: opts.blockchainAccount,
           filename_encrypted: btoa(thumb.name),
@@ -341,10 +366,12 @@ export async function addFileToArtwork(opts: AddFileOptions): Promise<{ fileId:
           iv: thumbEncrypted.nonce,
           auth_tag: thumbEncrypted.encryptedDeks[0].ephemeralPublicKey,
           is_thumbnail: true,
+          ...inlinePayload(thumbEncrypted.ciphertext),
         },
         opts.blockchainAccount,
         antelopeKey.privateKey
       );
+      const thumbId = allocatedId(thumbResult, 'addfile');
       await uploadStart({
         artwork_id: opts.artworkId,
         file_id: thumbId,
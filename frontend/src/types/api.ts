@@ -94,6 +94,7 @@ export interface PushTransactionResponse {
     id: string;
     block_num: number;
     block_time: string;
+    action_traces?: Array<{ return_value_data?: unknown }>;
   };
 }
 